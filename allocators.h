@@ -0,0 +1,440 @@
+#ifndef ALLOCATORS_H
+#define ALLOCATORS_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+// Types whose objects can be moved to another address with memcpy, after which the source is
+// released without running its destructor. Holds for trivially copyable types; specialize it
+// to std::true_type for others that qualify (e.g. handles owning a heap pointer).
+template<class T>
+struct IsTriviallyRelocatable : std::is_trivially_copyable<T> {};
+
+// Allocators may offer `T *Reallocate(T *array, size_t old_count, size_t new_count)`, which
+// returns a buffer of new_count elements holding the bytes of the first old_count, moved
+// bitwise. Containers call it only for trivially relocatable element types.
+template<class Allocator, class = void>
+struct HasReallocate : std::false_type {};
+
+template<class Allocator>
+struct HasReallocate<Allocator, std::void_t<decltype(std::declval<Allocator &>().Reallocate(
+    std::declval<typename Allocator::value_type *>(), std::size_t{}, std::size_t{}))> > : std::true_type {};
+
+// Allocators may also offer `bool TryExpand(T *array, size_t old_count, size_t new_count)`,
+// which grows a block to new_count elements without moving it or returns false. Any element
+// type can use it.
+template<class Allocator, class = void>
+struct HasTryExpand : std::false_type {};
+
+template<class Allocator>
+struct HasTryExpand<Allocator, std::void_t<decltype(std::declval<Allocator &>().TryExpand(
+    std::declval<typename Allocator::value_type *>(), std::size_t{}, std::size_t{}))> > : std::true_type {};
+
+// Allocators may also offer `size_t GoodCapacity(size_t count) const`, the capacity worth
+// allocating for count elements, e.g. rounded up to what the allocator hands out anyway.
+template<class Allocator, class = void>
+struct HasGoodCapacity : std::false_type {};
+
+template<class Allocator>
+struct HasGoodCapacity<Allocator, std::void_t<decltype(std::declval<const Allocator &>().GoodCapacity(
+    std::size_t{}))> > : std::true_type {};
+
+inline constexpr std::size_t AlignUp(std::size_t value, std::size_t alignment) {
+  return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// Default allocator of Vector: ::operator new, except for trivially relocatable types with
+// fundamental alignment, which live in malloc memory so that they can grow with realloc.
+template<class T>
+class HeapAllocator {
+  static constexpr bool kUseMalloc = IsTriviallyRelocatable<T>::value && alignof(T) <= alignof(std::max_align_t);
+
+public:
+  using value_type = T;
+  using is_always_equal = std::true_type;
+
+  HeapAllocator() = default;
+
+  template<class U>
+  HeapAllocator(const HeapAllocator<U> &) noexcept {  // NOLINT
+  }
+
+  T *allocate(std::size_t count) {  // NOLINT
+    if constexpr (kUseMalloc) {
+      auto *array = static_cast<T *>(std::malloc(count * sizeof(T)));
+      if (array == nullptr) {
+        throw std::bad_alloc();
+      }
+      return array;
+    } else {
+      return static_cast<T *>(::operator new(count * sizeof(T)));
+    }
+  }
+
+  void deallocate(T *array, std::size_t) noexcept {  // NOLINT
+    if constexpr (kUseMalloc) {
+      std::free(array);
+    } else {
+      ::operator delete(array);
+    }
+  }
+
+  template<class U = T, class = std::enable_if_t<HeapAllocator<U>::kUseMalloc> >
+  T *Reallocate(T *array, std::size_t, std::size_t new_count) {
+    auto *grown = static_cast<T *>(std::realloc(static_cast<void *>(array), new_count * sizeof(T)));
+    if (grown == nullptr) {
+      throw std::bad_alloc();
+    }
+    return grown;
+  }
+
+  template<class U>
+  bool operator==(const HeapAllocator<U> &) const {
+    return true;
+  }
+
+  template<class U>
+  bool operator!=(const HeapAllocator<U> &) const {
+    return false;
+  }
+
+  template<class U>
+  friend class HeapAllocator;
+};
+
+// Requests storage aligned to N bytes; Vector<T, Align<N> > stands for
+// Vector<T, AlignedAllocator<T, N> >.
+template<std::size_t N>
+struct Align {};
+
+// Aligned ::operator new. Capacities are padded to whole N-byte blocks whenever N is a
+// multiple of the element size, so a SIMD loop never has a partial last block.
+template<class T, std::size_t N>
+class AlignedAllocator {
+  static_assert(N > 0 && (N & (N - 1)) == 0, "AlignedAllocator needs a power-of-two alignment");
+  static_assert(N >= alignof(T), "AlignedAllocator cannot weaken the alignment of T");
+
+public:
+  using value_type = T;
+  using is_always_equal = std::true_type;
+
+  static constexpr std::size_t kAlignment = N;
+
+  template<class U>
+  struct rebind {  // NOLINT
+    using other = AlignedAllocator<U, std::max(N, alignof(U))>;
+  };
+
+  AlignedAllocator() = default;
+
+  template<class U, std::size_t M>
+  AlignedAllocator(const AlignedAllocator<U, M> &) noexcept {  // NOLINT
+  }
+
+  T *allocate(std::size_t count) {  // NOLINT
+    return static_cast<T *>(::operator new(count * sizeof(T), std::align_val_t{N}));
+  }
+
+  void deallocate(T *array, std::size_t) noexcept {  // NOLINT
+    ::operator delete(array, std::align_val_t{N});
+  }
+
+  [[nodiscard]] std::size_t GoodCapacity(std::size_t count) const {
+    if constexpr (N % sizeof(T) == 0) {
+      return AlignUp(count, N / sizeof(T));
+    } else {
+      return count;
+    }
+  }
+
+  template<class U, std::size_t M>
+  bool operator==(const AlignedAllocator<U, M> &) const {
+    return true;
+  }
+
+  template<class U, std::size_t M>
+  bool operator!=(const AlignedAllocator<U, M> &) const {
+    return false;
+  }
+};
+
+// Bump allocator over geometrically growing chunks. Individual frees are ignored, except that
+// the most recent allocation can be shrunk, grown in place or given back; everything is freed
+// at once by Release or the destructor. Not thread-safe.
+class MonotonicArena {
+  struct Chunk {
+    Chunk *previous;
+    std::size_t size;
+  };
+
+  static constexpr std::size_t kHeaderSize = AlignUp(sizeof(Chunk), alignof(std::max_align_t));
+
+  Chunk *chunks_ = nullptr;
+  char *cursor_ = nullptr;
+  char *limit_ = nullptr;
+  char *last_ = nullptr;
+  std::size_t next_chunk_size_;
+  std::size_t bytes_allocated_ = 0;
+
+  void AddChunk(std::size_t min_bytes) {
+    const std::size_t size = std::max(next_chunk_size_, min_bytes + kHeaderSize);
+    auto *chunk = static_cast<Chunk *>(::operator new(size));
+    chunk->previous = chunks_;
+    chunk->size = size;
+    chunks_ = chunk;
+    cursor_ = reinterpret_cast<char *>(chunk) + kHeaderSize;
+    limit_ = reinterpret_cast<char *>(chunk) + size;
+    last_ = nullptr;
+    next_chunk_size_ = size * 2;
+  }
+
+public:
+  explicit MonotonicArena(std::size_t first_chunk_size = 4096) : next_chunk_size_(first_chunk_size) {
+  }
+
+  MonotonicArena(const MonotonicArena &) = delete;
+  MonotonicArena &operator=(const MonotonicArena &) = delete;
+
+  ~MonotonicArena() {
+    Release();
+  }
+
+  void *Allocate(std::size_t bytes, std::size_t alignment) {
+    auto aligned = [&] {
+      return reinterpret_cast<char *>(AlignUp(reinterpret_cast<std::uintptr_t>(cursor_), alignment));
+    };
+    if (cursor_ == nullptr || aligned() + bytes > limit_) {
+      AddChunk(bytes + alignment);
+    }
+    char *result = aligned();
+    cursor_ = result + bytes;
+    last_ = result;
+    bytes_allocated_ += bytes;
+    return result;
+  }
+
+  // Resizes the most recent allocation in place; returns false for any other block or when
+  // the current chunk has no room.
+  bool TryResizeLast(void *block, std::size_t new_bytes) {
+    if (block == nullptr || block != last_ || last_ + new_bytes > limit_) {
+      return false;
+    }
+    bytes_allocated_ = bytes_allocated_ - static_cast<std::size_t>(cursor_ - last_) + new_bytes;
+    cursor_ = last_ + new_bytes;
+    return true;
+  }
+
+  void Deallocate(void *block, std::size_t) {
+    if (block != nullptr && block == last_) {
+      bytes_allocated_ -= static_cast<std::size_t>(cursor_ - last_);
+      cursor_ = last_;
+      last_ = nullptr;
+    }
+  }
+
+  void Release() noexcept {
+    while (chunks_ != nullptr) {
+      Chunk *previous = chunks_->previous;
+      ::operator delete(chunks_);
+      chunks_ = previous;
+    }
+    cursor_ = limit_ = last_ = nullptr;
+    bytes_allocated_ = 0;
+  }
+
+  [[nodiscard]] std::size_t BytesAllocated() const {
+    return bytes_allocated_;
+  }
+};
+
+template<class T>
+class ArenaAllocator {
+  MonotonicArena *arena_;
+
+  template<class U>
+  friend class ArenaAllocator;
+
+public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  explicit ArenaAllocator(MonotonicArena &arena) noexcept : arena_(&arena) {
+  }
+
+  template<class U>
+  ArenaAllocator(const ArenaAllocator<U> &other) noexcept : arena_(other.arena_) {  // NOLINT
+  }
+
+  T *allocate(std::size_t count) {  // NOLINT
+    return static_cast<T *>(arena_->Allocate(count * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T *array, std::size_t count) noexcept {  // NOLINT
+    arena_->Deallocate(array, count * sizeof(T));
+  }
+
+  bool TryExpand(T *array, std::size_t, std::size_t new_count) noexcept {
+    return arena_->TryResizeLast(array, new_count * sizeof(T));
+  }
+
+  // Grows in place when `array` is the newest block of the arena.
+  T *Reallocate(T *array, std::size_t old_count, std::size_t new_count) {
+    if (arena_->TryResizeLast(array, new_count * sizeof(T))) {
+      return array;
+    }
+    T *grown = allocate(new_count);
+    if (old_count > 0) {
+      std::memcpy(static_cast<void *>(grown), static_cast<const void *>(array), std::min(old_count, new_count) * sizeof(T));
+    }
+    return grown;
+  }
+
+  [[nodiscard]] MonotonicArena &Arena() const {
+    return *arena_;
+  }
+
+  template<class U>
+  bool operator==(const ArenaAllocator<U> &other) const {
+    return arena_ == other.arena_;
+  }
+
+  template<class U>
+  bool operator!=(const ArenaAllocator<U> &other) const {
+    return arena_ != other.arena_;
+  }
+};
+
+// Segregated free lists for power-of-two size classes from kMinBlock to kMaxBlock bytes,
+// carved out of kChunkSize chunks. Larger requests go to ::operator new. Freed blocks return
+// to their class list and memory goes back to the system only when the pool is destroyed.
+// Not thread-safe.
+class SizeClassPool {
+  struct FreeBlock {
+    FreeBlock *next;
+  };
+
+  static constexpr std::size_t kMinBlock = 16;
+  static constexpr std::size_t kMaxBlock = 4096;
+  static constexpr std::size_t kClassCount = 9;
+  static constexpr std::size_t kChunkSize = 64 * 1024;
+
+  FreeBlock *free_[kClassCount] = {};
+  void *chunks_ = nullptr;
+
+  static std::size_t ClassOf(std::size_t bytes) {
+    std::size_t index = 0;
+    for (std::size_t size = kMinBlock; size < bytes; size *= 2) {
+      ++index;
+    }
+    return index;
+  }
+
+  void Refill(std::size_t index) {
+    const std::size_t block = kMinBlock << index;
+    // The first block of every chunk holds the link to the previous chunk.
+    char *chunk = static_cast<char *>(::operator new(kChunkSize, std::align_val_t(kMaxBlock)));
+    *reinterpret_cast<void **>(chunk) = chunks_;
+    chunks_ = chunk;
+    for (std::size_t offset = block; offset + block <= kChunkSize; offset += block) {
+      auto *free_block = reinterpret_cast<FreeBlock *>(chunk + offset);
+      free_block->next = free_[index];
+      free_[index] = free_block;
+    }
+  }
+
+public:
+  SizeClassPool() = default;
+
+  SizeClassPool(const SizeClassPool &) = delete;
+  SizeClassPool &operator=(const SizeClassPool &) = delete;
+
+  ~SizeClassPool() {
+    while (chunks_ != nullptr) {
+      void *previous = *static_cast<void **>(chunks_);
+      ::operator delete(chunks_, std::align_val_t(kMaxBlock));
+      chunks_ = previous;
+    }
+  }
+
+  // Blocks are aligned to their size class (up to kMaxBlock), which covers any alignment not
+  // larger than the request.
+  void *Allocate(std::size_t bytes, std::size_t alignment) {
+    if (bytes > kMaxBlock || alignment > kMaxBlock) {
+      return ::operator new(bytes, std::align_val_t(std::max(alignment, alignof(std::max_align_t))));
+    }
+    const std::size_t index = ClassOf(std::max(bytes, alignment));
+    if (free_[index] == nullptr) {
+      Refill(index);
+    }
+    FreeBlock *block = free_[index];
+    free_[index] = block->next;
+    return block;
+  }
+
+  void Deallocate(void *block, std::size_t bytes, std::size_t alignment) noexcept {
+    if (block == nullptr) {
+      return;
+    }
+    if (bytes > kMaxBlock || alignment > kMaxBlock) {
+      ::operator delete(block, std::align_val_t(std::max(alignment, alignof(std::max_align_t))));
+      return;
+    }
+    const std::size_t index = ClassOf(std::max(bytes, alignment));
+    auto *free_block = static_cast<FreeBlock *>(block);
+    free_block->next = free_[index];
+    free_[index] = free_block;
+  }
+};
+
+template<class T>
+class PoolAllocator {
+  SizeClassPool *pool_;
+
+  template<class U>
+  friend class PoolAllocator;
+
+public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  explicit PoolAllocator(SizeClassPool &pool) noexcept : pool_(&pool) {
+  }
+
+  template<class U>
+  PoolAllocator(const PoolAllocator<U> &other) noexcept : pool_(other.pool_) {  // NOLINT
+  }
+
+  T *allocate(std::size_t count) {  // NOLINT
+    return static_cast<T *>(pool_->Allocate(count * sizeof(T), alignof(T)));
+  }
+
+  void deallocate(T *array, std::size_t count) noexcept {  // NOLINT
+    pool_->Deallocate(array, count * sizeof(T), alignof(T));
+  }
+
+  [[nodiscard]] SizeClassPool &Pool() const {
+    return *pool_;
+  }
+
+  template<class U>
+  bool operator==(const PoolAllocator<U> &other) const {
+    return pool_ == other.pool_;
+  }
+
+  template<class U>
+  bool operator!=(const PoolAllocator<U> &other) const {
+    return pool_ != other.pool_;
+  }
+};
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef BLOOM_FILTER_H
+#define BLOOM_FILTER_H
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include "hash_policy.h"
+
+// Split-block Bloom filter: every key maps to one 64-byte block and sets one bit in each of
+// its eight words, so a query touches a single cache line. Works on precomputed hashes as
+// well, which lets UnorderedSet reuse the hashes it already has.
+//
+// A filter without blocks (default-constructed) answers MayContain with true.
+template <class Key, class Hash = std::hash<Key> >
+class BloomFilter {
+  struct alignas(64) Block {
+    uint64_t words[8];
+  };
+
+  static constexpr uint32_t kSalts[8] = {0x47b6137bU, 0x44974d91U, 0x8824ad5bU, 0xa2b7289dU,
+                                         0x705495c7U, 0x2df1424bU, 0x9efc4947U, 0x5c6bfb31U};
+
+  std::vector<Block> blocks_;
+  size_t block_mask_ = 0;
+  Hash hash_;
+
+  // Seeded so that the bits used here are independent of the bucket index of a set that
+  // masks MixHash(hash) itself.
+  static uint64_t Mix(size_t hash) {
+    return MixHash(static_cast<uint64_t>(hash) + 0x9e3779b97f4a7c15ULL);
+  }
+
+  [[nodiscard]] size_t BlockIndex(uint64_t mixed) const {
+    return (mixed >> 32) & block_mask_;
+  }
+
+  static uint64_t BitFor(uint64_t mixed, size_t word) {
+    return uint64_t{1} << ((static_cast<uint32_t>(mixed) * kSalts[word]) >> 26);
+  }
+
+ public:
+  BloomFilter() = default;
+
+  explicit BloomFilter(size_t expected_elements, size_t bits_per_key = 10, const Hash &hash = Hash())
+      : hash_(hash) {
+    Reset(expected_elements, bits_per_key);
+  }
+
+  void Reset(size_t expected_elements, size_t bits_per_key = 10) {
+    const size_t bits = std::max<size_t>(expected_elements * bits_per_key, 1);
+    const size_t block_count = PowerOfTwoGrowthPolicy::BucketCountFor((bits + 511) / 512);
+    blocks_.assign(block_count, Block{});
+    block_mask_ = block_count - 1;
+  }
+
+  void Clear() {
+    std::fill(blocks_.begin(), blocks_.end(), Block{});
+  }
+
+  [[nodiscard]] size_t BitCount() const {
+    return blocks_.size() * 512;
+  }
+
+  void InsertHash(size_t hash) {
+    if (blocks_.empty()) {
+      return;
+    }
+    const uint64_t mixed = Mix(hash);
+    Block &block = blocks_[BlockIndex(mixed)];
+    for (size_t i = 0; i < 8; ++i) {
+      block.words[i] |= BitFor(mixed, i);
+    }
+  }
+
+  [[nodiscard]] bool MayContainHash(size_t hash) const {
+    if (blocks_.empty()) {
+      return true;
+    }
+    const uint64_t mixed = Mix(hash);
+    const Block &block = blocks_[BlockIndex(mixed)];
+    bool result = true;
+    for (size_t i = 0; i < 8; ++i) {
+      result &= (block.words[i] & BitFor(mixed, i)) != 0;
+    }
+    return result;
+  }
+
+  void PrefetchHash(size_t hash) const {
+    if (!blocks_.empty()) {
+      Prefetch(&blocks_[BlockIndex(Mix(hash))]);
+    }
+  }
+
+  void Insert(const Key &key) {
+    InsertHash(hash_(key));
+  }
+
+  [[nodiscard]] bool MayContain(const Key &key) const {
+    return MayContainHash(hash_(key));
+  }
+};
+
+#endif
@@ -0,0 +1,316 @@
+#ifndef CONCURRENT_UNORDERED_SET_H
+#define CONCURRENT_UNORDERED_SET_H
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <functional>
+#include <type_traits>
+#include "hash_policy.h"
+
+// Hash set split into independently locked shards. Writers lock only their shard; readers
+// never lock or wait. Every node has two chain links and consecutive bucket tables of a shard
+// use alternate ones, so a growing shard relinks its nodes into the new table while readers
+// go on searching the old one, which stays intact until it is freed.
+//
+// Erased nodes and replaced tables are freed once no reader can still be walking them. Each
+// shard counts its readers in two phases; a writer flips the phase and waits for the readers
+// of the previous one to leave, then frees what was retired before the flip. That happens
+// before every growth and every kMaxRetiredNodes erasures, so only writers wait, and only for
+// lookups already in progress.
+template <class Key, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>,
+          class GrowthPolicy = ExactGrowthPolicy>
+class ConcurrentUnorderedSet {
+  struct Node {
+    template <class K>
+    Node(size_t node_hash, K &&node_key) : hash(node_hash), key(std::forward<K>(node_key)) {
+    }
+
+    const size_t hash;
+    const Key key;
+    std::atomic<Node *> next[2] = {nullptr, nullptr};
+    std::atomic<bool> erased{false};
+  };
+
+  struct Table {
+    Table(size_t bucket_count, unsigned table_link) : baskets(bucket_count), link(table_link) {
+      policy.Reset(bucket_count);
+    }
+
+    std::vector<std::atomic<Node *> > baskets;
+    GrowthPolicy policy;
+    // Which of the nodes' next links chains this table.
+    const unsigned link;
+  };
+
+  struct alignas(64) Shard {
+    std::mutex mutex;
+    std::atomic<unsigned> phase{0};
+    std::atomic<size_t> readers[2] = {0, 0};
+    std::atomic<Table *> table{nullptr};
+    std::atomic<size_t> size{0};
+    std::unique_ptr<Table> owned_table;
+    std::unique_ptr<Table> retired_table;
+    std::vector<Node *> retired_nodes;
+  };
+
+  // Counts a lookup in its shard's current phase for as long as it runs.
+  class ReadGuard {
+    Shard &shard_;
+    unsigned phase_;
+
+   public:
+    explicit ReadGuard(Shard &shard) : shard_(shard) {
+      while (true) {
+        phase_ = shard_.phase.load();
+        shard_.readers[phase_].fetch_add(1);
+        // A writer that flipped the phase in between may not have seen this reader.
+        if (shard_.phase.load() == phase_) {
+          return;
+        }
+        shard_.readers[phase_].fetch_sub(1, std::memory_order_release);
+      }
+    }
+
+    ReadGuard(const ReadGuard &) = delete;
+    ReadGuard &operator=(const ReadGuard &) = delete;
+
+    ~ReadGuard() {
+      shard_.readers[phase_].fetch_sub(1, std::memory_order_release);
+    }
+  };
+
+  static constexpr size_t kDefaultShardCount = 64;
+  static constexpr size_t kInitialBucketCount = 8;
+  static constexpr size_t kMaxRetiredNodes = 64;
+
+  std::unique_ptr<Shard[]> shards_;
+  size_t shard_count_ = 0;
+  unsigned shard_shift_ = 0;
+  Hash hash_;
+  KeyEqual key_equal_;
+
+  template <class K>
+  using EnableIfTransparent =
+      std::enable_if_t<IsTransparent<Hash>::value && IsTransparent<KeyEqual>::value &&
+                       !std::is_same_v<std::decay_t<K>, Key> >;
+
+  Shard &ShardFor(size_t hash) const {
+    return shards_[shard_count_ == 1 ? 0 : MixHash(hash) >> shard_shift_];
+  }
+
+  template <class K>
+  Node *Search(const Table *table, const K &key, size_t hash) const {
+    Node *node = table->baskets[table->policy.Index(hash)].load(std::memory_order_acquire);
+    for (; node != nullptr; node = node->next[table->link].load(std::memory_order_acquire)) {
+      if (node->hash == hash && key_equal_(node->key, key) && !node->erased.load(std::memory_order_acquire)) {
+        return node;
+      }
+    }
+    return nullptr;
+  }
+
+  // Frees the retired nodes and table of a shard once the readers that could still reach them
+  // have left. The caller holds the shard's mutex.
+  static void ReclaimRetired(Shard &shard) {
+    if (shard.retired_nodes.empty() && !shard.retired_table) {
+      return;
+    }
+    const unsigned phase = shard.phase.load(std::memory_order_relaxed);
+    shard.phase.store(phase ^ 1);
+    while (shard.readers[phase].load() != 0) {
+      std::this_thread::yield();
+    }
+    for (Node *node : shard.retired_nodes) {
+      delete node;
+    }
+    shard.retired_nodes.clear();
+    shard.retired_table.reset();
+  }
+
+  void Grow(Shard &shard, size_t bucket_count) {
+    Table *old_table = shard.owned_table.get();
+    auto new_table = std::make_unique<Table>(GrowthPolicy::BucketCountFor(bucket_count), old_table->link ^ 1);
+    // Readers of the table before the current one may still follow the links rewritten here.
+    ReclaimRetired(shard);
+    const unsigned old_link = old_table->link;
+    const unsigned new_link = new_table->link;
+    for (auto &basket : old_table->baskets) {
+      for (Node *node = basket.load(std::memory_order_relaxed); node != nullptr;
+           node = node->next[old_link].load(std::memory_order_relaxed)) {
+        auto &head = new_table->baskets[new_table->policy.Index(node->hash)];
+        node->next[new_link].store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+        head.store(node, std::memory_order_relaxed);
+      }
+    }
+    shard.table.store(new_table.get(), std::memory_order_release);
+    shard.retired_table = std::move(shard.owned_table);
+    shard.owned_table = std::move(new_table);
+  }
+
+  template <class K>
+  bool FindImpl(const K &key) const {
+    const size_t hash = hash_(key);
+    Shard &shard = ShardFor(hash);
+    const ReadGuard guard(shard);
+    return Search(shard.table.load(std::memory_order_acquire), key, hash) != nullptr;
+  }
+
+  template <class K>
+  bool InsertImpl(K &&key) {
+    const size_t hash = hash_(key);
+    Shard &shard = ShardFor(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Table *table = shard.owned_table.get();
+    if (Search(table, key, hash) != nullptr) {
+      return false;
+    }
+    auto node = std::make_unique<Node>(hash, std::forward<K>(key));
+    const size_t size = shard.size.load(std::memory_order_relaxed);
+    if (size + 1 > table->baskets.size()) {
+      Grow(shard, GrowthPolicy::NextBucketCount(table->baskets.size()));
+      table = shard.owned_table.get();
+    }
+    auto &head = table->baskets[table->policy.Index(hash)];
+    node->next[table->link].store(head.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    head.store(node.release(), std::memory_order_release);
+    shard.size.store(size + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  template <class K>
+  bool EraseImpl(const K &key) {
+    const size_t hash = hash_(key);
+    Shard &shard = ShardFor(hash);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    Table *table = shard.owned_table.get();
+    std::atomic<Node *> *link = &table->baskets[table->policy.Index(hash)];
+    for (Node *node = link->load(std::memory_order_relaxed); node != nullptr;
+         node = link->load(std::memory_order_relaxed)) {
+      if (node->hash == hash && key_equal_(node->key, key)) {
+        shard.retired_nodes.push_back(node);
+        node->erased.store(true, std::memory_order_release);
+        link->store(node->next[table->link].load(std::memory_order_relaxed), std::memory_order_release);
+        shard.size.fetch_sub(1, std::memory_order_relaxed);
+        if (shard.retired_nodes.size() >= kMaxRetiredNodes) {
+          ReclaimRetired(shard);
+        }
+        return true;
+      }
+      link = &node->next[table->link];
+    }
+    return false;
+  }
+
+  void Destroy() {
+    if (!shards_) {
+      return;
+    }
+    for (size_t i = 0; i < shard_count_; ++i) {
+      ReclaimRetired(shards_[i]);
+      const unsigned link = shards_[i].owned_table->link;
+      for (auto &basket : shards_[i].owned_table->baskets) {
+        Node *node = basket.load(std::memory_order_relaxed);
+        while (node != nullptr) {
+          Node *next = node->next[link].load(std::memory_order_relaxed);
+          delete node;
+          node = next;
+        }
+      }
+    }
+    shards_.reset();
+  }
+
+ public:
+  explicit ConcurrentUnorderedSet(size_t shard_count = kDefaultShardCount, const Hash &hash = Hash(),
+                                  const KeyEqual &key_equal = KeyEqual())
+      : hash_(hash), key_equal_(key_equal) {
+    shard_count_ = PowerOfTwoGrowthPolicy::BucketCountFor(shard_count);
+    shard_shift_ = 64;
+    for (size_t count = shard_count_; count > 1; count >>= 1) {
+      --shard_shift_;
+    }
+    shards_ = std::make_unique<Shard[]>(shard_count_);
+    for (size_t i = 0; i < shard_count_; ++i) {
+      shards_[i].owned_table = std::make_unique<Table>(GrowthPolicy::BucketCountFor(kInitialBucketCount), 0);
+      shards_[i].retired_nodes.reserve(kMaxRetiredNodes);
+      shards_[i].table.store(shards_[i].owned_table.get(), std::memory_order_release);
+    }
+  }
+
+  ConcurrentUnorderedSet(const ConcurrentUnorderedSet &) = delete;
+  ConcurrentUnorderedSet &operator=(const ConcurrentUnorderedSet &) = delete;
+
+  ~ConcurrentUnorderedSet() {
+    Destroy();
+  }
+
+  [[nodiscard]] size_t ShardCount() const {
+    return shard_count_;
+  }
+
+  [[nodiscard]] size_t Size() const {
+    size_t size = 0;
+    for (size_t i = 0; i < shard_count_; ++i) {
+      size += shards_[i].size.load(std::memory_order_relaxed);
+    }
+    return size;
+  }
+
+  [[nodiscard]] bool Empty() const {
+    return Size() == 0;
+  }
+
+  bool Find(const Key &key) const {
+    return FindImpl(key);
+  }
+
+  template <class K, class = EnableIfTransparent<K> >
+  bool Find(const K &key) const {
+    return FindImpl(key);
+  }
+
+  bool InsertIfAbsent(const Key &key) {
+    return InsertImpl(key);
+  }
+
+  bool InsertIfAbsent(Key &&key) {
+    return InsertImpl(std::move(key));
+  }
+
+  template <class K, class = EnableIfTransparent<K>, class = std::enable_if_t<std::is_constructible_v<Key, K &&> > >
+  bool InsertIfAbsent(K &&key) {
+    return InsertImpl(std::forward<K>(key));
+  }
+
+  bool Erase(const Key &key) {
+    return EraseImpl(key);
+  }
+
+  template <class K, class = EnableIfTransparent<K> >
+  bool Erase(const K &key) {
+    return EraseImpl(key);
+  }
+
+  void Reserve(size_t elements) {
+    const size_t per_shard = (elements + shard_count_ - 1) / shard_count_;
+    for (size_t i = 0; i < shard_count_; ++i) {
+      std::lock_guard<std::mutex> lock(shards_[i].mutex);
+      if (per_shard > shards_[i].owned_table->baskets.size()) {
+        Grow(shards_[i], per_shard);
+      }
+    }
+  }
+
+  // Frees the erased nodes and the replaced tables that are still held back, waiting for the
+  // lookups in progress to finish.
+  void Reclaim() {
+    for (size_t i = 0; i < shard_count_; ++i) {
+      std::lock_guard<std::mutex> lock(shards_[i].mutex);
+      ReclaimRetired(shards_[i]);
+    }
+  }
+};
+
+#endif
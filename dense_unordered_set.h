@@ -0,0 +1,272 @@
+#ifndef DENSE_UNORDERED_SET_H
+#define DENSE_UNORDERED_SET_H
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include "hash_policy.h"
+
+// Same interface as UnorderedSet, but elements live in one contiguous array and buckets
+// hold indices into it. Erase moves the last element into the freed slot, so iteration
+// order changes and iterators are invalidated by Erase.
+template <class Key, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>,
+          class GrowthPolicy = ExactGrowthPolicy>
+class DenseUnorderedSet {
+  static constexpr size_t kNone = static_cast<size_t>(-1);
+
+  std::vector<Key> elements_;
+  std::vector<size_t> hashes_;
+  std::vector<size_t> next_;
+  std::vector<size_t> baskets_;
+  Hash hash_;
+  KeyEqual key_equal_;
+  GrowthPolicy policy_;
+  float max_load_factor_ = 1.0f;
+
+  template <class K>
+  using EnableIfTransparent =
+      std::enable_if_t<IsTransparent<Hash>::value && IsTransparent<KeyEqual>::value &&
+                       !std::is_same_v<std::decay_t<K>, Key> >;
+
+  template <class K>
+  size_t FindIndex(const K &key, size_t hash) const {
+    if (baskets_.empty()) {
+      return kNone;
+    }
+    for (size_t i = baskets_[policy_.Index(hash)]; i != kNone; i = next_[i]) {
+      if (hashes_[i] == hash && key_equal_(elements_[i], key)) {
+        return i;
+      }
+    }
+    return kNone;
+  }
+
+  [[nodiscard]] size_t MinBucketCountFor(size_t elements) const {
+    return static_cast<size_t>(std::ceil(static_cast<float>(elements) / max_load_factor_));
+  }
+
+  void Link(size_t index) {
+    size_t &head = baskets_[policy_.Index(hashes_[index])];
+    next_[index] = head;
+    head = index;
+  }
+
+  template <class K>
+  std::pair<typename std::vector<Key>::const_iterator, bool> InsertImpl(K &&key) {
+    const size_t hash = hash_(key);
+    if (const size_t found = FindIndex(key, hash); found != kNone) {
+      return {elements_.cbegin() + static_cast<std::ptrdiff_t>(found), false};
+    }
+    if (static_cast<float>(Size() + 1) > static_cast<float>(BucketCount()) * max_load_factor_) {
+      Rehash(std::max(GrowthPolicy::NextBucketCount(BucketCount()), MinBucketCountFor(Size() + 1)));
+    }
+    elements_.emplace_back(std::forward<K>(key));
+    try {
+      hashes_.push_back(hash);
+      next_.push_back(kNone);
+    } catch (...) {
+      elements_.pop_back();
+      hashes_.resize(elements_.size());
+      throw;
+    }
+    Link(elements_.size() - 1);
+    return {elements_.cend() - 1, true};
+  }
+
+  template <class K>
+  void EraseImpl(const K &key) {
+    if (baskets_.empty()) {
+      return;
+    }
+    const size_t hash = hash_(key);
+    size_t *link = &baskets_[policy_.Index(hash)];
+    while (*link != kNone && !(hashes_[*link] == hash && key_equal_(elements_[*link], key))) {
+      link = &next_[*link];
+    }
+    if (*link == kNone) {
+      return;
+    }
+    const size_t index = *link;
+    *link = next_[index];
+    const size_t last = elements_.size() - 1;
+    if (index != last) {
+      size_t *last_link = &baskets_[policy_.Index(hashes_[last])];
+      while (*last_link != last) {
+        last_link = &next_[*last_link];
+      }
+      *last_link = index;
+      elements_[index] = std::move(elements_[last]);
+      hashes_[index] = hashes_[last];
+      next_[index] = next_[last];
+    }
+    elements_.pop_back();
+    hashes_.pop_back();
+    next_.pop_back();
+  }
+
+ public:
+  using ConstIterator = typename std::vector<Key>::const_iterator;
+  using Iterator = ConstIterator;
+
+  DenseUnorderedSet() = default;
+
+  explicit DenseUnorderedSet(size_t bucket_count, const Hash &hash = Hash(), const KeyEqual &key_equal = KeyEqual())
+      : hash_(hash), key_equal_(key_equal) {
+    Rehash(bucket_count);
+  }
+
+  template <class Forward>
+  DenseUnorderedSet(Forward first, Forward last, const Hash &hash = Hash(), const KeyEqual &key_equal = KeyEqual())
+      : hash_(hash), key_equal_(key_equal) {
+    if (first != last) {
+      const auto count = static_cast<size_t>(std::distance(first, last));
+      Rehash(count);
+      elements_.reserve(count);
+      hashes_.reserve(count);
+      next_.reserve(count);
+      for (auto it = first; it != last; ++it) {
+        Insert(*it);
+      }
+    }
+  }
+
+  template <class K, class = EnableIfTransparent<K> >
+  size_t Bucket(const K &key) const {
+    return policy_.Index(hash_(key));
+  }
+
+  size_t Bucket(const Key &key) const {
+    return policy_.Index(hash_(key));
+  }
+
+  [[nodiscard]] size_t BucketCount() const {
+    return baskets_.size();
+  }
+
+  [[nodiscard]] size_t BucketSize(size_t id) const {
+    size_t size = 0;
+    if (id < BucketCount()) {
+      for (size_t i = baskets_[id]; i != kNone; i = next_[i]) {
+        ++size;
+      }
+    }
+    return size;
+  }
+
+  [[nodiscard]] float LoadFactor() const {
+    if (baskets_.empty()) {
+      return 0.0f;
+    }
+    return static_cast<float>(Size()) / BucketCount();
+  }
+
+  [[nodiscard]] float MaxLoadFactor() const {
+    return max_load_factor_;
+  }
+
+  void MaxLoadFactor(float max_load_factor) {
+    if (!(max_load_factor > 0.0f)) {
+      return;
+    }
+    max_load_factor_ = max_load_factor;
+    if (LoadFactor() > max_load_factor_) {
+      Rehash(MinBucketCountFor(Size()));
+    }
+  }
+
+  void Rehash(const size_t new_bucket_count) {
+    const size_t bucket_count = GrowthPolicy::BucketCountFor(new_bucket_count);
+    if (bucket_count == BucketCount() ||
+        static_cast<float>(bucket_count) * max_load_factor_ < static_cast<float>(Size())) {
+      return;
+    }
+    baskets_.assign(bucket_count, kNone);
+    policy_.Reset(bucket_count);
+    for (size_t i = 0; i < elements_.size(); ++i) {
+      Link(i);
+    }
+  }
+
+  void Reserve(size_t new_bucket_count) {
+    if (new_bucket_count > BucketCount()) {
+      Rehash(new_bucket_count);
+    }
+  }
+
+  [[nodiscard]] size_t Size() const {
+    return elements_.size();
+  }
+
+  [[nodiscard]] bool Empty() const {
+    return elements_.empty();
+  }
+
+  void Clear() {
+    elements_.clear();
+    hashes_.clear();
+    next_.clear();
+    std::fill(baskets_.begin(), baskets_.end(), kNone);
+  }
+
+  bool Find(const Key &key) const {
+    return FindIndex(key, hash_(key)) != kNone;
+  }
+
+  template <class K, class = EnableIfTransparent<K> >
+  bool Find(const K &key) const {
+    return FindIndex(key, hash_(key)) != kNone;
+  }
+
+  std::pair<ConstIterator, bool> Insert(const Key &key) {
+    return InsertImpl(key);
+  }
+
+  std::pair<ConstIterator, bool> Insert(Key &&key) {
+    return InsertImpl(std::move(key));
+  }
+
+  template <class K, class = EnableIfTransparent<K>, class = std::enable_if_t<std::is_constructible_v<Key, K &&> > >
+  std::pair<ConstIterator, bool> Insert(K &&key) {
+    return InsertImpl(std::forward<K>(key));
+  }
+
+  template <class... Args>
+  std::pair<ConstIterator, bool> Emplace(Args &&...args) {
+    Key key(std::forward<Args>(args)...);
+    return InsertImpl(std::move(key));
+  }
+
+  void Erase(const Key &key) {
+    EraseImpl(key);
+  }
+
+  template <class K, class = EnableIfTransparent<K> >
+  void Erase(const K &key) {
+    EraseImpl(key);
+  }
+
+  const Key *Data() const {
+    return elements_.data();
+  }
+
+  ConstIterator begin() const {    //NOLINT
+    return elements_.begin();
+  }
+
+  ConstIterator end() const {    //NOLINT
+    return elements_.end();
+  }
+
+  ConstIterator cbegin() const {    //NOLINT
+    return elements_.begin();
+  }
+
+  ConstIterator cend() const {    //NOLINT
+    return elements_.end();
+  }
+};
+
+#endif
@@ -0,0 +1,124 @@
+#ifndef HASH_POLICY_H
+#define HASH_POLICY_H
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <type_traits>
+
+template <class T, class = void>
+struct IsTransparent : std::false_type {};
+
+template <class T>
+struct IsTransparent<T, std::void_t<typename T::is_transparent> > : std::true_type {};
+
+inline void Prefetch(const void *address) {
+#if defined(__GNUC__) || defined(__clang__)
+  __builtin_prefetch(address);
+#else
+  (void)address;
+#endif
+}
+
+inline uint64_t MixHash(uint64_t hash) {
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdULL;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+// Keeps the requested bucket count as is. Indexing masks when the count is a power of two
+// (which is what doubling growth produces) and falls back to modulo otherwise.
+class ExactGrowthPolicy {
+  size_t bucket_count_ = 0;
+  size_t mask_ = 0;
+  bool is_power_of_two_ = false;
+
+ public:
+  static size_t BucketCountFor(size_t requested) {
+    return requested;
+  }
+
+  static size_t NextBucketCount(size_t current) {
+    return current == 0 ? 1 : current * 2;
+  }
+
+  void Reset(size_t bucket_count) {
+    bucket_count_ = bucket_count;
+    is_power_of_two_ = bucket_count != 0 && (bucket_count & (bucket_count - 1)) == 0;
+    mask_ = bucket_count - 1;
+  }
+
+  [[nodiscard]] size_t Index(size_t hash) const {
+    return is_power_of_two_ ? hash & mask_ : hash % bucket_count_;
+  }
+};
+
+// Power-of-two bucket counts. The hash is post-mixed so that weak hashes (like the identity
+// std::hash for integers) still spread over the low bits selected by the mask.
+class PowerOfTwoGrowthPolicy {
+  static constexpr size_t kMaxBucketCount = (SIZE_MAX >> 1) + 1;
+
+  size_t mask_ = 0;
+
+ public:
+  static size_t BucketCountFor(size_t requested) {
+    if (requested > kMaxBucketCount) {
+      throw std::length_error("PowerOfTwoGrowthPolicy::BucketCountFor");
+    }
+    size_t count = 1;
+    while (count < requested) {
+      count <<= 1;
+    }
+    return count;
+  }
+
+  static size_t NextBucketCount(size_t current) {
+    return current == 0 ? 1 : BucketCountFor(current > kMaxBucketCount / 2 ? SIZE_MAX : current * 2);
+  }
+
+  void Reset(size_t bucket_count) {
+    mask_ = bucket_count - 1;
+  }
+
+  [[nodiscard]] size_t Index(size_t hash) const {
+    return MixHash(hash) & mask_;
+  }
+};
+
+// Prime bucket counts, roughly doubling. The modulo is computed with a precomputed
+// reciprocal (Lemire's fastmod), so indexing costs two multiplications instead of a division.
+class PrimeGrowthPolicy {
+  static constexpr uint32_t kPrimes[] = {
+      2,         5,         11,        23,        53,        97,         193,        389,
+      769,       1543,      3079,      6151,      12289,     24593,      49157,      98317,
+      196613,    393241,    786433,    1572869,   3145739,   6291469,    12582917,   25165843,
+      50331653,  100663319, 201326611, 402653189, 805306457, 1610612741, 3221225473, 4294967291};
+
+  uint64_t reciprocal_ = 0;
+  uint32_t divisor_ = 1;
+
+ public:
+  static size_t BucketCountFor(size_t requested) {
+    auto it = std::lower_bound(std::begin(kPrimes), std::end(kPrimes), requested);
+    return it == std::end(kPrimes) ? kPrimes[std::size(kPrimes) - 1] : *it;
+  }
+
+  static size_t NextBucketCount(size_t current) {
+    return BucketCountFor(current == 0 ? 1 : current * 2);
+  }
+
+  void Reset(size_t bucket_count) {
+    divisor_ = static_cast<uint32_t>(bucket_count);
+    reciprocal_ = divisor_ == 0 ? 0 : UINT64_MAX / divisor_ + 1;
+  }
+
+  [[nodiscard]] size_t Index(size_t hash) const {
+    const auto folded = static_cast<uint32_t>(hash ^ (static_cast<uint64_t>(hash) >> 32));
+    const uint64_t low_bits = reciprocal_ * folded;
+    return static_cast<size_t>((static_cast<__uint128_t>(low_bits) * divisor_) >> 64);
+  }
+};
+
+#endif
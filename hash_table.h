@@ -0,0 +1,866 @@
+#ifndef HASH_TABLE_H
+#define HASH_TABLE_H
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <type_traits>
+#include <cmath>
+#include <iterator>
+#include <utility>
+#include <span>
+#include <cstdint>
+#include <stdexcept>
+#include <chrono>
+#include "hash_policy.h"
+#include "node_pool.h"
+#include "bloom_filter.h"
+#include "thread_pool.h"
+
+// Snapshot returned by Stats() of UnorderedSet and UnorderedMap. The table shape is computed
+// on demand; the lookup and rehash counters are collected only when UNORDERED_SET_STATS is
+// defined and stay zero otherwise. Slot k of a histogram counts buckets holding k elements or
+// lookups that compared k nodes; the last slot also counts everything larger.
+struct HashTableStats {
+  static constexpr size_t kHistogramSize = 16;
+
+  size_t size = 0;
+  size_t bucket_count = 0;
+  float load_factor = 0.0f;
+  size_t max_chain_length = 0;
+  size_t bucket_size_histogram[kHistogramSize] = {};
+  size_t probe_length_histogram[kHistogramSize] = {};
+  double bytes_per_element = 0.0;
+  uint64_t rehash_count = 0;
+  uint64_t rehash_nanoseconds = 0;
+  uint64_t find_hits = 0;
+  uint64_t find_misses = 0;
+};
+
+using UnorderedSetStats = HashTableStats;
+
+struct IdentityKey {
+  template <class T>
+  const T &operator()(const T &value) const {
+    return value;
+  }
+};
+
+struct PairFirstKey {
+  template <class Pair>
+  const auto &operator()(const Pair &value) const {
+    return value.first;
+  }
+};
+
+// Separate-chaining engine shared by UnorderedSet and UnorderedMap. Nodes hold a Value, the
+// cached hash of its key and the chain link; KeyOfValue extracts the key from a Value (or
+// from anything a Value is built from, for bulk insertion).
+template <class Key, class Value, class KeyOfValue, class Hash, class KeyEqual, class GrowthPolicy>
+class HashTable {
+ protected:
+  struct Node {
+    template <class... Args>
+    explicit Node(size_t node_hash, Args &&...args) : hash(node_hash), value(std::forward<Args>(args)...) {
+    }
+
+    Node *next = nullptr;
+    size_t hash;
+    Value value;
+  };
+
+  static const Key &KeyOf(const Value &value) {
+    return KeyOfValue{}(value);
+  }
+
+  std::vector<Node *> baskets_;
+  NodePool<Node> pool_;
+  size_t elements_count_ = 0;
+  Hash hash_;
+  KeyEqual key_equal_;
+  GrowthPolicy policy_;
+  float max_load_factor_ = 1.0f;
+  BloomFilter<Key, Hash> bloom_;
+  size_t bloom_bits_per_key_ = 0;
+  // Generation-tagged clearing: a bucket whose tag differs from generation_ is empty, whatever
+  // its chain still holds.
+  std::vector<uint32_t> generations_;
+  uint32_t generation_ = 0;
+  bool generation_clear_ = false;
+
+#ifdef UNORDERED_SET_STATS
+  // Updated from const lookups, so a set with stats enabled must not be probed concurrently.
+  mutable HashTableStats counters_;
+#endif
+
+  static constexpr size_t kProbeWindow = 16;
+  static constexpr size_t kParallelHashThreshold = 1 << 16;
+
+ public:
+  template <bool kConst>
+  class IteratorImpl {
+    friend class HashTable;
+    template <bool>
+    friend class IteratorImpl;
+    using NodePointer = std::conditional_t<kConst, const Node *, Node *>;
+
+    NodePointer const *basket_ = nullptr;
+    NodePointer const *baskets_end_ = nullptr;
+    const uint32_t *generation_ = nullptr;
+    uint32_t current_generation_ = 0;
+    NodePointer node_ = nullptr;
+
+    // Without a node, starts at the first element stored in `basket` or after it.
+    IteratorImpl(NodePointer const *basket, NodePointer const *baskets_end, const uint32_t *generation,
+                 uint32_t current_generation, NodePointer node)
+        : basket_(basket), baskets_end_(baskets_end), generation_(generation),
+          current_generation_(current_generation), node_(node) {
+      if (node_ == nullptr) {
+        SkipEmptyBaskets();
+      }
+    }
+
+    [[nodiscard]] bool LiveBasket() const {
+      return *basket_ != nullptr && (generation_ == nullptr || *generation_ == current_generation_);
+    }
+
+    void NextBasket() {
+      ++basket_;
+      if (generation_ != nullptr) {
+        ++generation_;
+      }
+    }
+
+    void SkipEmptyBaskets() {
+      while (basket_ != baskets_end_ && !LiveBasket()) {
+        NextBasket();
+      }
+      node_ = basket_ != baskets_end_ ? *basket_ : nullptr;
+    }
+
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Value;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<kConst, const Value *, Value *>;
+    using reference = std::conditional_t<kConst, const Value &, Value &>;
+
+    IteratorImpl() = default;
+
+    template <bool kOtherConst, class = std::enable_if_t<kConst && !kOtherConst> >
+    IteratorImpl(const IteratorImpl<kOtherConst> &other)  // NOLINT
+        : basket_(other.basket_), baskets_end_(other.baskets_end_), generation_(other.generation_),
+          current_generation_(other.current_generation_), node_(other.node_) {
+    }
+
+    reference operator*() const {
+      return node_->value;
+    }
+
+    pointer operator->() const {
+      return &node_->value;
+    }
+
+    IteratorImpl &operator++() {
+      node_ = node_->next;
+      if (node_ == nullptr) {
+        NextBasket();
+        SkipEmptyBaskets();
+      }
+      return *this;
+    }
+
+    IteratorImpl operator++(int) {
+      IteratorImpl copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    bool operator==(const IteratorImpl &other) const {
+      return node_ == other.node_;
+    }
+
+    bool operator!=(const IteratorImpl &other) const {
+      return !(*this == other);
+    }
+  };
+
+  using ConstIterator = IteratorImpl<true>;
+  using MutableIterator = IteratorImpl<false>;
+
+ protected:
+  template <class K>
+  using EnableIfTransparent =
+      std::enable_if_t<IsTransparent<Hash>::value && IsTransparent<KeyEqual>::value &&
+                       !std::is_same_v<std::decay_t<K>, Key> >;
+
+  template <class K>
+  Node *FindInBasket(Node *node, const K &key, size_t hash) const {
+    while (node != nullptr && !(node->hash == hash && key_equal_(KeyOf(node->value), key))) {
+      node = node->next;
+    }
+    return node;
+  }
+
+  [[nodiscard]] bool Stale(size_t index) const {
+    return generation_clear_ && generations_[index] != generation_;
+  }
+
+  Node *Head(size_t index) const {
+    return Stale(index) ? nullptr : baskets_[index];
+  }
+
+  void ReleaseChain(Node *&head) noexcept {
+    while (head != nullptr) {
+      Node *next = head->next;
+      pool_.Delete(head);
+      head = next;
+    }
+  }
+
+  // Head of a bucket that is about to change. The nodes of a stale bucket go back to the pool
+  // here, so the cost of a generation clear is paid by the buckets that are used again.
+  Node *&LiveHead(size_t index) {
+    if (Stale(index)) {
+      ReleaseChain(baskets_[index]);
+      generations_[index] = generation_;
+    }
+    return baskets_[index];
+  }
+
+  template <class Iterator>
+  Iterator IteratorAt(size_t index, Node *node) const {
+    const uint32_t *generation = generation_clear_ ? generations_.data() + index : nullptr;
+    return Iterator(baskets_.data() + index, baskets_.data() + baskets_.size(), generation, generation_, node);
+  }
+
+  ConstIterator MakeIterator(Node *node) const {
+    if (node == nullptr) {
+      return end();
+    }
+    return IteratorAt<ConstIterator>(policy_.Index(node->hash), node);
+  }
+
+  template <class K>
+  Node *FindNode(const K &key, size_t hash) const {
+    if (Empty() || !bloom_.MayContainHash(hash)) {
+      return nullptr;
+    }
+    return FindInBasket(Head(policy_.Index(hash)), key, hash);
+  }
+
+  void RecordLookup([[maybe_unused]] const Node *head, [[maybe_unused]] const Node *found) const {
+#ifdef UNORDERED_SET_STATS
+    size_t probes = 0;
+    for (const Node *node = head; node != found; node = node->next) {
+      ++probes;
+    }
+    if (found != nullptr) {
+      ++probes;
+      ++counters_.find_hits;
+    } else {
+      ++counters_.find_misses;
+    }
+    ++counters_.probe_length_histogram[std::min(probes, HashTableStats::kHistogramSize - 1)];
+#endif
+  }
+
+  // FindNode for the lookups made by the user, which the stats count.
+  template <class K>
+  Node *LookupNode(const K &key) const {
+    if (Empty()) {
+      RecordLookup(nullptr, nullptr);
+      return nullptr;
+    }
+    const size_t hash = hash_(key);
+    if (!bloom_.MayContainHash(hash)) {
+      RecordLookup(nullptr, nullptr);
+      return nullptr;
+    }
+    Node *head = Head(policy_.Index(hash));
+    Node *found = FindInBasket(head, key, hash);
+    RecordLookup(head, found);
+    return found;
+  }
+
+  template <class K>
+  bool FindImpl(const K &key) const {
+    return LookupNode(key) != nullptr;
+  }
+
+  template <class K>
+  size_t BucketImpl(const K &key) const {
+    return policy_.Index(hash_(key));
+  }
+
+  [[nodiscard]] size_t MinBucketCountFor(size_t elements) const {
+    return static_cast<size_t>(std::ceil(static_cast<float>(elements) / max_load_factor_));
+  }
+
+  void ResetBuckets(size_t bucket_count) {
+    if (bucket_count == 0) {
+      return;
+    }
+    bucket_count = GrowthPolicy::BucketCountFor(bucket_count);
+    baskets_.assign(bucket_count, nullptr);
+    if (generation_clear_) {
+      generations_.assign(bucket_count, generation_);
+    }
+    policy_.Reset(bucket_count);
+  }
+
+  void GrowFor(size_t elements) {
+    if (static_cast<float>(elements) > static_cast<float>(BucketCount()) * max_load_factor_) {
+      Rehash(std::max(GrowthPolicy::NextBucketCount(BucketCount()), MinBucketCountFor(elements)));
+    }
+  }
+
+  void PushFront(Node *node) {
+    Node *&head = LiveHead(policy_.Index(node->hash));
+    node->next = head;
+    head = node;
+    bloom_.InsertHash(node->hash);
+  }
+
+  // Sized for the number of elements the table holds before its next growth; rebuilding on
+  // every rehash also drops the bits left behind by erased keys.
+  void RebuildBloomFilter() {
+    const auto capacity = static_cast<size_t>(static_cast<float>(BucketCount()) * max_load_factor_);
+    bloom_.Reset(std::max(capacity, elements_count_), bloom_bits_per_key_);
+    for (size_t i = 0; i < baskets_.size(); ++i) {
+      for (const Node *node = Head(i); node != nullptr; node = node->next) {
+        bloom_.InsertHash(node->hash);
+      }
+    }
+  }
+
+  // Links a node whose key is known to be absent.
+  Node *LinkNode(Node *node) {
+    try {
+      GrowFor(elements_count_ + 1);
+    } catch (...) {
+      pool_.Delete(node);
+      throw;
+    }
+    PushFront(node);
+    ++elements_count_;
+    return node;
+  }
+
+  // The single lookup of every insertion: `key` (hashed to `hash`) is searched once and the
+  // Value is built from `args` only when the key is absent.
+  template <class K, class... Args>
+  std::pair<Node *, bool> FindOrInsert(const K &key, size_t hash, Args &&...args) {
+    if (Node *found = FindNode(key, hash)) {
+      return {found, false};
+    }
+    return {LinkNode(pool_.New(hash, std::forward<Args>(args)...)), true};
+  }
+
+  template <class... Args>
+  std::pair<Node *, bool> EmplaceNode(Args &&...args) {
+    Node *node = pool_.New(0, std::forward<Args>(args)...);
+    Node *found = nullptr;
+    try {
+      node->hash = hash_(KeyOf(node->value));
+      found = FindNode(KeyOf(node->value), node->hash);
+    } catch (...) {
+      pool_.Delete(node);
+      throw;
+    }
+    if (found != nullptr) {
+      pool_.Delete(node);
+      return {found, false};
+    }
+    return {LinkNode(node), true};
+  }
+
+  void DestroyNodes() noexcept {
+    for (Node *&head : baskets_) {
+      ReleaseChain(head);
+    }
+    elements_count_ = 0;
+  }
+
+  void CopyNodes(const HashTable &other) {
+    baskets_.assign(other.baskets_.size(), nullptr);
+    if (generation_clear_) {
+      generations_.assign(baskets_.size(), generation_);
+    }
+    pool_.Reserve(other.elements_count_);
+    try {
+      for (size_t i = 0; i < other.baskets_.size(); ++i) {
+        Node **tail = &baskets_[i];
+        for (const Node *node = other.Head(i); node != nullptr; node = node->next) {
+          *tail = pool_.New(node->hash, node->value);
+          tail = &(*tail)->next;
+          ++elements_count_;
+        }
+      }
+    } catch (...) {
+      DestroyNodes();
+      throw;
+    }
+  }
+
+  // Resolves keys in windows: hash the window and prefetch the Bloom filter blocks, prefetch
+  // the bucket slots of keys that pass the filter, then their first nodes, then compare.
+  // Cache misses of a window overlap.
+  template <class Callback>
+  void ProbeMany(std::span<const Key> keys, Callback &&on_result) const {
+    constexpr size_t kFiltered = static_cast<size_t>(-1);
+    size_t indices[kProbeWindow];
+    size_t hashes[kProbeWindow];
+    for (size_t base = 0; base < keys.size(); base += kProbeWindow) {
+      const size_t count = std::min(kProbeWindow, keys.size() - base);
+      for (size_t i = 0; i < count; ++i) {
+        hashes[i] = hash_(keys[base + i]);
+        bloom_.PrefetchHash(hashes[i]);
+      }
+      for (size_t i = 0; i < count; ++i) {
+        indices[i] = bloom_.MayContainHash(hashes[i]) ? policy_.Index(hashes[i]) : kFiltered;
+        if (indices[i] != kFiltered) {
+          Prefetch(&baskets_[indices[i]]);
+        }
+      }
+      for (size_t i = 0; i < count; ++i) {
+        if (indices[i] != kFiltered) {
+          Prefetch(Head(indices[i]));
+        }
+      }
+      for (size_t i = 0; i < count; ++i) {
+        if (indices[i] == kFiltered) {
+          RecordLookup(nullptr, nullptr);
+          on_result(base + i, false);
+          continue;
+        }
+        Node *head = Head(indices[i]);
+        const Node *found = FindInBasket(head, keys[base + i], hashes[i]);
+        RecordLookup(head, found);
+        on_result(base + i, found != nullptr);
+      }
+    }
+  }
+
+  // Large random-access ranges are hashed on ThreadPool::Default(); an exception from hash_
+  // reaches the caller once every piece has stopped.
+  template <class Forward>
+  void HashRange(Forward first, std::vector<size_t> &hashes) const {
+    const size_t count = hashes.size();
+    if constexpr (std::is_base_of_v<std::random_access_iterator_tag,
+                                    typename std::iterator_traits<Forward>::iterator_category>) {
+      if (count >= kParallelHashThreshold) {
+        ThreadPool::Default().ParallelFor(count, kParallelHashThreshold / 4, [&](size_t begin, size_t end) {
+          for (size_t i = begin; i < end; ++i) {
+            hashes[i] = hash_(KeyOfValue{}(first[i]));
+          }
+        });
+        return;
+      }
+    }
+    for (size_t i = 0; i < count; ++i, ++first) {
+      hashes[i] = hash_(KeyOfValue{}(*first));
+    }
+  }
+
+  template <class K>
+  void EraseImpl(const K &key) {
+    if (baskets_.empty()) {
+      return;
+    }
+    const size_t hash = hash_(key);
+    Node **link = &LiveHead(policy_.Index(hash));
+    while (*link != nullptr && !((*link)->hash == hash && key_equal_(KeyOf((*link)->value), key))) {
+      link = &(*link)->next;
+    }
+    if (*link != nullptr) {
+      Node *node = *link;
+      *link = node->next;
+      pool_.Delete(node);
+      --elements_count_;
+    }
+  }
+
+ public:
+  size_t Bucket(const Key &key) const {
+    return BucketImpl(key);
+  }
+
+  template <class K, class = EnableIfTransparent<K> >
+  size_t Bucket(const K &key) const {
+    return BucketImpl(key);
+  }
+
+  [[nodiscard]] size_t BucketCount() const {
+    if (baskets_.empty()) {
+      return 0;
+    }
+    return baskets_.size();
+  }
+
+  [[nodiscard]] size_t BucketSize(size_t id) const {
+    size_t size = 0;
+    if (id < BucketCount()) {
+      for (const Node *node = Head(id); node != nullptr; node = node->next) {
+        ++size;
+      }
+    }
+    return size;
+  }
+
+  [[nodiscard]] float LoadFactor() const {
+    if (baskets_.empty()) {
+      return 0.0f;
+    }
+    return static_cast<float>(elements_count_) / BucketCount();
+  }
+
+  [[nodiscard]] Hash HashFunction() const {
+    return hash_;
+  }
+
+  [[nodiscard]] KeyEqual KeyEq() const {
+    return key_equal_;
+  }
+
+  [[nodiscard]] float MaxLoadFactor() const {
+    return max_load_factor_;
+  }
+
+  void MaxLoadFactor(float max_load_factor) {
+    if (!(max_load_factor > 0.0f)) {
+      return;
+    }
+    max_load_factor_ = max_load_factor;
+    if (LoadFactor() > max_load_factor_) {
+      Rehash(MinBucketCountFor(elements_count_));
+    }
+  }
+
+  void Rehash(const size_t new_bucket_count) {
+    const size_t bucket_count = GrowthPolicy::BucketCountFor(new_bucket_count);
+    if (bucket_count == BucketCount() ||
+        static_cast<float>(bucket_count) * max_load_factor_ < static_cast<float>(elements_count_)) {
+      return;
+    }
+#ifdef UNORDERED_SET_STATS
+    const auto rehash_start = std::chrono::steady_clock::now();
+#endif
+    std::vector<Node *> new_baskets(bucket_count, nullptr);
+    std::vector<uint32_t> new_generations(generation_clear_ ? bucket_count : 0, generation_);
+    GrowthPolicy new_policy;
+    new_policy.Reset(bucket_count);
+    for (size_t i = 0; i < baskets_.size(); ++i) {
+      if (Stale(i)) {
+        ReleaseChain(baskets_[i]);
+        continue;
+      }
+      Node *node = baskets_[i];
+      while (node != nullptr) {
+        Node *next = node->next;
+        Node *&head = new_baskets[new_policy.Index(node->hash)];
+        node->next = head;
+        head = node;
+        node = next;
+      }
+    }
+    baskets_ = std::move(new_baskets);
+    generations_ = std::move(new_generations);
+    policy_ = new_policy;
+    if (bloom_bits_per_key_ != 0) {
+      RebuildBloomFilter();
+    }
+#ifdef UNORDERED_SET_STATS
+    ++counters_.rehash_count;
+    counters_.rehash_nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - rehash_start).count();
+#endif
+  }
+
+  [[nodiscard]] HashTableStats Stats() const {
+    HashTableStats stats;
+#ifdef UNORDERED_SET_STATS
+    stats = counters_;
+#endif
+    stats.size = elements_count_;
+    stats.bucket_count = BucketCount();
+    stats.load_factor = LoadFactor();
+    for (size_t i = 0; i < baskets_.size(); ++i) {
+      size_t length = 0;
+      for (const Node *node = Head(i); node != nullptr; node = node->next) {
+        ++length;
+      }
+      stats.max_chain_length = std::max(stats.max_chain_length, length);
+      ++stats.bucket_size_histogram[std::min(length, HashTableStats::kHistogramSize - 1)];
+    }
+    if (elements_count_ != 0) {
+      const size_t bytes = sizeof(*this) + baskets_.capacity() * sizeof(Node *) +
+                           generations_.capacity() * sizeof(uint32_t) + pool_.BytesReserved() +
+                           bloom_.BitCount() / 8;
+      stats.bytes_per_element = static_cast<double>(bytes) / static_cast<double>(elements_count_);
+    }
+    return stats;
+  }
+
+  void ResetStats() {
+#ifdef UNORDERED_SET_STATS
+    counters_ = HashTableStats();
+#endif
+  }
+
+  HashTable() = default;
+
+  explicit HashTable(size_t bucket_count, const Hash &hash = Hash(), const KeyEqual &key_equal = KeyEqual())
+      : hash_(hash), key_equal_(key_equal) {
+    ResetBuckets(bucket_count);
+  }
+
+  template <class Forward>
+  HashTable(Forward first, Forward last, const Hash &hash = Hash(), const KeyEqual &key_equal = KeyEqual())
+      : hash_(hash), key_equal_(key_equal) {
+    if (first != last) {
+      ResetBuckets(std::distance(first, last));
+      InsertRange(first, last);
+    }
+  }
+
+  HashTable(const HashTable &other)
+      : hash_(other.hash_), key_equal_(other.key_equal_), policy_(other.policy_),
+        max_load_factor_(other.max_load_factor_), bloom_(other.bloom_),
+        bloom_bits_per_key_(other.bloom_bits_per_key_), generation_clear_(other.generation_clear_) {
+    CopyNodes(other);
+  }
+
+  HashTable(HashTable &&other) noexcept
+      : hash_(other.hash_), key_equal_(other.key_equal_), policy_(other.policy_),
+        max_load_factor_(other.max_load_factor_), bloom_(std::move(other.bloom_)),
+        bloom_bits_per_key_(other.bloom_bits_per_key_), generations_(std::move(other.generations_)),
+        generation_(other.generation_), generation_clear_(other.generation_clear_) {
+    baskets_ = std::move(other.baskets_);
+    pool_ = std::move(other.pool_);
+    elements_count_ = other.elements_count_;
+    other.elements_count_ = 0;
+    other.baskets_.clear();
+    other.generations_.clear();
+  }
+
+  ~HashTable() {
+    DestroyNodes();
+  }
+
+  HashTable &operator=(const HashTable &other) {
+    if (this != &other) {
+      HashTable copy(other);
+      *this = std::move(copy);
+    }
+    return *this;
+  }
+
+  HashTable &operator=(HashTable &&other) noexcept {
+    if (this != &other) {
+      DestroyNodes();
+      baskets_ = std::move(other.baskets_);
+      pool_ = std::move(other.pool_);
+      elements_count_ = other.elements_count_;
+      hash_ = other.hash_;
+      key_equal_ = other.key_equal_;
+      policy_ = other.policy_;
+      max_load_factor_ = other.max_load_factor_;
+      bloom_ = std::move(other.bloom_);
+      bloom_bits_per_key_ = other.bloom_bits_per_key_;
+      generations_ = std::move(other.generations_);
+      generation_ = other.generation_;
+      generation_clear_ = other.generation_clear_;
+      other.baskets_.clear();
+      other.generations_.clear();
+      other.elements_count_ = 0;
+    }
+    return *this;
+  }
+
+  [[nodiscard]] size_t Size() const {
+    return elements_count_;
+  }
+
+  [[nodiscard]] bool Empty() const {
+    return elements_count_ == 0;
+  }
+
+  // Keeps the bucket array and returns every node to the pool, so refilling the table up to
+  // its previous size allocates nothing. With generation clearing enabled only the generation
+  // counter moves.
+  void Clear() {
+    if (generation_clear_ && ++generation_ != 0) {
+      elements_count_ = 0;
+    } else {
+      DestroyNodes();
+    }
+    bloom_.Clear();
+  }
+
+  // Makes Clear O(1) for tables that are cleared and refilled in a loop: buckets are tagged
+  // with the generation that last wrote them and older tags read as empty. Cleared nodes are
+  // destroyed lazily, when their bucket is written again, on rehash or with the table, and
+  // stay allocated until then. A Bloom filter, if enabled, is still zeroed by Clear.
+  void EnableGenerationClear() {
+    if (!generation_clear_) {
+      generations_.assign(baskets_.size(), generation_);
+      generation_clear_ = true;
+    }
+  }
+
+  void DisableGenerationClear() {
+    for (size_t i = 0; i < baskets_.size(); ++i) {
+      if (Stale(i)) {
+        ReleaseChain(baskets_[i]);
+      }
+    }
+    generation_clear_ = false;
+    generations_ = std::vector<uint32_t>();
+  }
+
+  [[nodiscard]] bool GenerationClearEnabled() const {
+    return generation_clear_;
+  }
+
+  // Keeps a blocked Bloom filter in front of the buckets so that most misses are answered
+  // from one cache line. Erased keys keep their bits until the next rehash.
+  void EnableBloomFilter(size_t bits_per_key = 10) {
+    bloom_bits_per_key_ = std::max<size_t>(bits_per_key, 1);
+    RebuildBloomFilter();
+  }
+
+  void DisableBloomFilter() {
+    bloom_bits_per_key_ = 0;
+    bloom_ = BloomFilter<Key, Hash>();
+  }
+
+  [[nodiscard]] bool BloomFilterEnabled() const {
+    return bloom_bits_per_key_ != 0;
+  }
+
+  bool Find(const Key &key) const {
+    return FindImpl(key);
+  }
+
+  template <class K, class = EnableIfTransparent<K> >
+  bool Find(const K &key) const {
+    return FindImpl(key);
+  }
+
+  void ContainsMany(std::span<const Key> keys, std::span<bool> result) const {
+    if (result.size() < keys.size()) {
+      throw std::invalid_argument("HashTable::ContainsMany");
+    }
+    if (Empty()) {
+      std::fill_n(result.begin(), keys.size(), false);
+      return;
+    }
+    ProbeMany(keys, [&](size_t i, bool found) { result[i] = found; });
+  }
+
+  // Bit i of the bitmap is set when keys[i] is present.
+  void FindMany(std::span<const Key> keys, std::span<uint64_t> bitmap) const {
+    const size_t words = (keys.size() + 63) / 64;
+    if (bitmap.size() < words) {
+      throw std::invalid_argument("HashTable::FindMany");
+    }
+    std::fill_n(bitmap.begin(), words, 0);
+    if (Empty()) {
+      return;
+    }
+    ProbeMany(keys, [&](size_t i, bool found) { bitmap[i / 64] |= static_cast<uint64_t>(found) << (i % 64); });
+  }
+
+  // Sizes the table once for the whole range, hashes the input in one pass (split across
+  // threads for large random-access ranges), orders it by bucket with a counting sort and then
+  // fills the buckets without per-element growth checks.
+  template <class Forward>
+  void InsertRange(Forward first, Forward last) {
+    if constexpr (!std::is_base_of_v<std::forward_iterator_tag,
+                                     typename std::iterator_traits<Forward>::iterator_category>) {
+      for (; first != last; ++first) {
+        EmplaceNode(*first);
+      }
+    } else {
+      const auto count = static_cast<size_t>(std::distance(first, last));
+      if (count == 0) {
+        return;
+      }
+      GrowFor(elements_count_ + count);
+      pool_.Reserve(elements_count_ + count);
+      std::vector<size_t> hashes(count);
+      HashRange(first, hashes);
+      std::vector<size_t> offsets(baskets_.size() + 1, 0);
+      for (size_t hash : hashes) {
+        ++offsets[policy_.Index(hash) + 1];
+      }
+      for (size_t i = 1; i < offsets.size(); ++i) {
+        offsets[i] += offsets[i - 1];
+      }
+      std::vector<Forward> order(count);
+      std::vector<size_t> order_hashes(count);
+      for (size_t i = 0; i < count; ++i, ++first) {
+        const size_t slot = offsets[policy_.Index(hashes[i])]++;
+        order[slot] = first;
+        order_hashes[slot] = hashes[i];
+      }
+      for (size_t i = 0; i < count; ++i) {
+        const Key &key = KeyOfValue{}(*order[i]);
+        if (FindInBasket(Head(policy_.Index(order_hashes[i])), key, order_hashes[i]) == nullptr) {
+          PushFront(pool_.New(order_hashes[i], *order[i]));
+          ++elements_count_;
+        }
+      }
+    }
+  }
+
+  void Erase(const Key &key) {
+    EraseImpl(key);
+  }
+
+  template <class K, class = EnableIfTransparent<K> >
+  void Erase(const K &key) {
+    EraseImpl(key);
+  }
+
+  void Reserve(size_t new_bucket_count) {
+    if (new_bucket_count > BucketCount()) {
+      Rehash(new_bucket_count);
+    }
+  }
+
+ protected:
+  MutableIterator MutableBegin() {
+    return IteratorAt<MutableIterator>(0, nullptr);
+  }
+
+  MutableIterator MutableEnd() {
+    return IteratorAt<MutableIterator>(baskets_.size(), nullptr);
+  }
+
+  MutableIterator MakeMutableIterator(Node *node) {
+    if (node == nullptr) {
+      return MutableEnd();
+    }
+    return IteratorAt<MutableIterator>(policy_.Index(node->hash), node);
+  }
+
+ public:
+  ConstIterator begin() const {    //NOLINT
+    return IteratorAt<ConstIterator>(0, nullptr);
+  }
+
+  ConstIterator end() const {    //NOLINT
+    return IteratorAt<ConstIterator>(baskets_.size(), nullptr);
+  }
+
+  ConstIterator cbegin() const {    //NOLINT
+    return begin();
+  }
+
+  ConstIterator cend() const {    //NOLINT
+    return end();
+  }
+};
+
+#endif
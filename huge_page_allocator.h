@@ -0,0 +1,140 @@
+#ifndef HUGE_PAGE_ALLOCATOR_H
+#define HUGE_PAGE_ALLOCATOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <sys/mman.h>
+#include "allocators.h"
+
+// Allocator for very large buffers. Each allocation reserves a range of address space with
+// mmap and commits only the pages the requested count needs; TryExpand commits more of the
+// range, so a Vector using it grows without copying until the reservation is full. By default
+// the reservation is the smallest 2 MiB * 16^k that holds the request, up to 64 GiB, which lets
+// a doubling Vector grow four times in place between moves; an explicit reservation_bytes
+// (kLargeReservation, say) reserves that much for every buffer instead. The range is aligned to
+// 2 MiB and advised with MADV_HUGEPAGE, so that the kernel can back it with transparent huge
+// pages when the system's THP mode allows it.
+//
+//   Vector<double, HugePageAllocator<double> > samples;
+template<class T>
+class HugePageAllocator {
+  static constexpr std::size_t kReservationGrowth = 16;
+  static constexpr std::size_t kMaxDefaultReservation = std::size_t{64} << 30;
+
+  // Zero picks the reservation from the request.
+  std::size_t reservation_bytes_ = 0;
+
+  template<class U>
+  friend class HugePageAllocator;
+
+  // The reservation made for a buffer of `bytes`. TryExpand only grows a buffer while this
+  // stays the same, so deallocate can recompute it from the final count.
+  [[nodiscard]] std::size_t ReservationFor(std::size_t bytes) const {
+    const std::size_t needed = AlignUp(bytes, kHugePageSize);
+    if (reservation_bytes_ != 0) {
+      return std::max(reservation_bytes_, needed);
+    }
+    std::size_t reservation = kHugePageSize;
+    while (reservation < needed && reservation < kMaxDefaultReservation) {
+      reservation *= kReservationGrowth;
+    }
+    return std::max(std::min(reservation, kMaxDefaultReservation), needed);
+  }
+
+  static std::size_t CommittedFor(std::size_t count) {
+    return AlignUp(count * sizeof(T), kHugePageSize);
+  }
+
+public:
+  using value_type = T;
+  using propagate_on_container_copy_assignment = std::true_type;
+  using propagate_on_container_move_assignment = std::true_type;
+  using propagate_on_container_swap = std::true_type;
+
+  static constexpr std::size_t kHugePageSize = std::size_t{2} << 20;
+  static constexpr std::size_t kLargeReservation = std::size_t{64} << 30;
+
+  static_assert(alignof(T) <= kHugePageSize, "HugePageAllocator aligns buffers to 2 MiB at most");
+
+  HugePageAllocator() = default;
+
+  explicit HugePageAllocator(std::size_t reservation_bytes) noexcept
+      : reservation_bytes_(AlignUp(reservation_bytes, kHugePageSize)) {
+  }
+
+  template<class U>
+  HugePageAllocator(const HugePageAllocator<U> &other) noexcept  // NOLINT
+      : reservation_bytes_(other.reservation_bytes_) {
+  }
+
+  T *allocate(std::size_t count) {  // NOLINT
+    if (count > SIZE_MAX / sizeof(T) - kHugePageSize) {
+      throw std::bad_alloc();
+    }
+    const std::size_t reservation = ReservationFor(count * sizeof(T));
+    // One extra huge page lets the start be moved up to a 2 MiB boundary.
+    const std::size_t mapped = reservation + kHugePageSize;
+    void *raw = ::mmap(nullptr, mapped, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (raw == MAP_FAILED) {
+      throw std::bad_alloc();
+    }
+    auto *base = static_cast<char *>(raw);
+    char *start = reinterpret_cast<char *>(AlignUp(reinterpret_cast<std::uintptr_t>(base), kHugePageSize));
+    const std::size_t head = static_cast<std::size_t>(start - base);
+    if (head > 0) {
+      ::munmap(base, head);
+    }
+    if (head < kHugePageSize) {
+      ::munmap(start + reservation, kHugePageSize - head);
+    }
+#ifdef MADV_HUGEPAGE
+    ::madvise(start, reservation, MADV_HUGEPAGE);
+#endif
+    const std::size_t committed = CommittedFor(count);
+    if (committed > 0 && ::mprotect(start, committed, PROT_READ | PROT_WRITE) != 0) {
+      ::munmap(start, reservation);
+      throw std::bad_alloc();
+    }
+    return reinterpret_cast<T *>(start);
+  }
+
+  void deallocate(T *array, std::size_t count) noexcept {  // NOLINT
+    ::munmap(array, ReservationFor(count * sizeof(T)));
+  }
+
+  // Commits the pages for new_count elements when they fall in the same reservation as old_count.
+  bool TryExpand(T *array, std::size_t old_count, std::size_t new_count) noexcept {
+    if (new_count <= old_count) {
+      return true;
+    }
+    if (new_count > SIZE_MAX / sizeof(T) - kHugePageSize
+        || ReservationFor(new_count * sizeof(T)) != ReservationFor(old_count * sizeof(T))) {
+      return false;
+    }
+    const std::size_t committed = CommittedFor(old_count);
+    const std::size_t needed = CommittedFor(new_count);
+    if (needed == committed) {
+      return true;
+    }
+    return ::mprotect(reinterpret_cast<char *>(array) + committed, needed - committed, PROT_READ | PROT_WRITE) == 0;
+  }
+
+  [[nodiscard]] std::size_t ReservationBytes() const {
+    return reservation_bytes_;
+  }
+
+  template<class U>
+  bool operator==(const HugePageAllocator<U> &other) const {
+    return reservation_bytes_ == other.reservation_bytes_;
+  }
+
+  template<class U>
+  bool operator!=(const HugePageAllocator<U> &other) const {
+    return reservation_bytes_ != other.reservation_bytes_;
+  }
+};
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+class MappedFileError : public std::runtime_error {
+public:
+  explicit MappedFileError(const std::string &what) : std::runtime_error("MappedFileError: " + what) {
+  }
+};
+
+inline void WriteAll(int fd, const void *data, size_t size) {
+  const char *bytes = static_cast<const char *>(data);
+  while (size > 0) {
+    const ssize_t written = ::write(fd, bytes, size);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw MappedFileError(std::string("write: ") + std::strerror(errno));
+    }
+    bytes += written;
+    size -= static_cast<size_t>(written);
+  }
+}
+
+inline void ReadAll(int fd, void *data, size_t size) {
+  char *bytes = static_cast<char *>(data);
+  while (size > 0) {
+    const ssize_t got = ::read(fd, bytes, size);
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw MappedFileError(std::string("read: ") + std::strerror(errno));
+    }
+    if (got == 0) {
+      throw MappedFileError("read: unexpected end of file");
+    }
+    bytes += got;
+    size -= static_cast<size_t>(got);
+  }
+}
+
+class FileDescriptor {
+  int fd_ = -1;
+
+public:
+  FileDescriptor(const std::string &path, int flags, mode_t mode = 0644) {
+    fd_ = ::open(path.c_str(), flags | O_CLOEXEC, mode);
+    if (fd_ < 0) {
+      throw MappedFileError("open " + path + ": " + std::strerror(errno));
+    }
+  }
+
+  FileDescriptor(const FileDescriptor &) = delete;
+  FileDescriptor &operator=(const FileDescriptor &) = delete;
+
+  ~FileDescriptor() {
+    if (fd_ >= 0) {
+      ::close(fd_);
+    }
+  }
+
+  [[nodiscard]] int Get() const {
+    return fd_;
+  }
+};
+
+// Read-only, shared mapping of a whole file; processes mapping the same file share its pages.
+class MappedFile {
+  void *data_ = nullptr;
+  size_t size_ = 0;
+
+public:
+  MappedFile() = default;
+
+  explicit MappedFile(const std::string &path) {
+    FileDescriptor file(path, O_RDONLY);
+    struct stat info {};
+    if (::fstat(file.Get(), &info) != 0) {
+      throw MappedFileError("fstat " + path + ": " + std::strerror(errno));
+    }
+    size_ = static_cast<size_t>(info.st_size);
+    if (size_ > 0) {
+      data_ = ::mmap(nullptr, size_, PROT_READ, MAP_SHARED, file.Get(), 0);
+      if (data_ == MAP_FAILED) {
+        data_ = nullptr;
+        throw MappedFileError("mmap " + path + ": " + std::strerror(errno));
+      }
+    }
+  }
+
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+
+  MappedFile(MappedFile &&other) noexcept : data_(other.data_), size_(other.size_) {
+    other.data_ = nullptr;
+    other.size_ = 0;
+  }
+
+  MappedFile &operator=(MappedFile &&other) noexcept {
+    if (this != &other) {
+      Unmap();
+      data_ = other.data_;
+      size_ = other.size_;
+      other.data_ = nullptr;
+      other.size_ = 0;
+    }
+    return *this;
+  }
+
+  ~MappedFile() {
+    Unmap();
+  }
+
+  void Unmap() noexcept {
+    if (data_ != nullptr) {
+      ::munmap(data_, size_);
+      data_ = nullptr;
+      size_ = 0;
+    }
+  }
+
+  [[nodiscard]] const char *Data() const {
+    return static_cast<const char *>(data_);
+  }
+
+  [[nodiscard]] size_t Size() const {
+    return size_;
+  }
+};
+
+#endif
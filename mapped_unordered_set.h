@@ -0,0 +1,114 @@
+#ifndef MAPPED_UNORDERED_SET_H
+#define MAPPED_UNORDERED_SET_H
+#include <cstring>
+#include <functional>
+#include <string>
+#include <type_traits>
+#include "hash_policy.h"
+#include "mapped_file.h"
+#include "unordered_set_snapshot.h"
+
+// Read-only set answering lookups straight from a snapshot written by
+// UnorderedSet::SaveSnapshot. Opening it maps and validates the file; nothing is deserialized.
+template <class Key, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key> >
+class MappedUnorderedSet {
+  static_assert(std::is_trivially_copyable_v<Key>, "snapshots store keys as raw bytes");
+
+  MappedFile file_;
+  UnorderedSetSnapshotHeader header_{};
+  const uint64_t *offsets_ = nullptr;
+  const uint64_t *hashes_ = nullptr;
+  const Key *keys_ = nullptr;
+  Hash hash_;
+  KeyEqual key_equal_;
+
+  template <class K>
+  using EnableIfTransparent =
+      std::enable_if_t<IsTransparent<Hash>::value && IsTransparent<KeyEqual>::value &&
+                       !std::is_same_v<std::decay_t<K>, Key> >;
+
+  void Validate(const std::string &path) {
+    if (file_.Size() < sizeof(header_)) {
+      throw MappedFileError(path + ": too small for a snapshot header");
+    }
+    std::memcpy(&header_, file_.Data(), sizeof(header_));
+    if (std::memcmp(header_.magic, UnorderedSetSnapshotHeader::kMagic, sizeof(header_.magic)) != 0) {
+      throw MappedFileError(path + ": not an UnorderedSet snapshot");
+    }
+    if (header_.key_size != sizeof(Key) || header_.key_alignment != alignof(Key)) {
+      throw MappedFileError(path + ": snapshot was written for a different key type");
+    }
+    // Every element takes a hash and a key, which bounds the size before any layout arithmetic.
+    if (header_.size > (file_.Size() - sizeof(header_)) / (sizeof(uint64_t) + sizeof(Key))) {
+      throw MappedFileError(path + ": corrupt snapshot layout");
+    }
+    const auto expected = MakeSnapshotHeader<Key>(header_.size);
+    if (std::memcmp(&expected, &header_, sizeof(header_)) != 0 || header_.file_size != file_.Size()) {
+      throw MappedFileError(path + ": corrupt snapshot layout");
+    }
+  }
+
+  template <class K>
+  bool FindImpl(const K &key) const {
+    const size_t hash = hash_(key);
+    const size_t bucket = SnapshotBucket(hash, header_.bucket_count);
+    for (uint64_t i = offsets_[bucket]; i < offsets_[bucket + 1]; ++i) {
+      if (hashes_[i] == hash && key_equal_(keys_[i], key)) {
+        return true;
+      }
+    }
+    return false;
+  }
+
+ public:
+  using ConstIterator = const Key *;
+  using Iterator = ConstIterator;
+
+  explicit MappedUnorderedSet(const std::string &path, const Hash &hash = Hash(), const KeyEqual &key_equal = KeyEqual())
+      : file_(path), hash_(hash), key_equal_(key_equal) {
+    Validate(path);
+    offsets_ = reinterpret_cast<const uint64_t *>(file_.Data() + header_.offsets_offset);
+    hashes_ = reinterpret_cast<const uint64_t *>(file_.Data() + header_.hashes_offset);
+    keys_ = reinterpret_cast<const Key *>(file_.Data() + header_.keys_offset);
+    // Lookups trust the offsets, so they must start at 0, never decrease and end at size.
+    if (offsets_[0] != 0 || offsets_[header_.bucket_count] != header_.size) {
+      throw MappedFileError(path + ": corrupt bucket offsets");
+    }
+    for (uint64_t b = 0; b < header_.bucket_count; ++b) {
+      if (offsets_[b] > offsets_[b + 1]) {
+        throw MappedFileError(path + ": corrupt bucket offsets");
+      }
+    }
+  }
+
+  [[nodiscard]] size_t Size() const {
+    return header_.size;
+  }
+
+  [[nodiscard]] bool Empty() const {
+    return header_.size == 0;
+  }
+
+  [[nodiscard]] size_t BucketCount() const {
+    return header_.bucket_count;
+  }
+
+  bool Find(const Key &key) const {
+    return FindImpl(key);
+  }
+
+  template <class K, class = EnableIfTransparent<K> >
+  bool Find(const K &key) const {
+    return FindImpl(key);
+  }
+
+  ConstIterator begin() const {    //NOLINT
+    return keys_;
+  }
+
+  ConstIterator end() const {    //NOLINT
+    return keys_ + header_.size;
+  }
+};
+
+#endif
@@ -0,0 +1,103 @@
+#ifndef MAPPED_VECTOR_H
+#define MAPPED_VECTOR_H
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include "mapped_file.h"
+#include "vector_file.h"
+
+// Read-only view of a file holding one record written by WriteVector. Opening it maps the file
+// and validates the header; the elements are used in place.
+template<class T>
+class MappedVector {
+  static_assert(std::is_trivially_copyable_v<T>, "Vector records store elements as raw bytes");
+
+public:
+  using ValueType = T;
+  using ConstPointer = const T *;
+  using ConstReference = const T &;
+  using SizeType = std::size_t;
+  using ConstIterator = ConstPointer;
+  using ConstReverseIterator = std::reverse_iterator<ConstIterator>;
+
+private:
+  MappedFile file_;
+  ConstPointer data_ = nullptr;
+  SizeType size_ = 0;
+
+public:
+  MappedVector() = default;
+
+  explicit MappedVector(const std::string &path) : file_(path) {
+    VectorFileHeader header;
+    if (file_.Size() < sizeof(header)) {
+      throw MappedFileError(path + ": too small for a Vector record header");
+    }
+    std::memcpy(&header, file_.Data(), sizeof(header));
+    ValidateVectorFileHeader<T>(header, path);
+    if (header.data_offset > file_.Size() || header.size > (file_.Size() - header.data_offset) / sizeof(T)) {
+      throw MappedFileError(path + ": truncated Vector record");
+    }
+    data_ = reinterpret_cast<ConstPointer>(file_.Data() + header.data_offset);
+    size_ = static_cast<SizeType>(header.size);
+  }
+
+  [[nodiscard]] SizeType Size() const { return size_; }
+  [[nodiscard]] bool Empty() const { return size_ == 0; }
+
+  const ValueType &operator[](SizeType i) const { return data_[i]; }
+
+  const ValueType &At(SizeType i) const {
+    if (i >= size_) {
+      throw std::out_of_range("MappedVector::At");
+    }
+    return data_[i];
+  }
+
+  const ValueType &Front() const {
+    return data_[0];
+  }
+
+  const ValueType &Back() const {
+    return data_[size_ - 1];
+  }
+
+  ConstPointer Data() const { return data_; }
+
+  ConstIterator begin() const {    //NOLINT
+    return data_;
+  }
+
+  ConstIterator cbegin() const {    //NOLINT
+    return data_;
+  }
+
+  ConstIterator end() const {    //NOLINT
+    return data_ + size_;
+  }
+
+  ConstIterator cend() const {    //NOLINT
+    return data_ + size_;
+  }
+
+  ConstReverseIterator rbegin() const {    //NOLINT
+    return ConstReverseIterator(end());
+  }
+
+  ConstReverseIterator rend() const {    //NOLINT
+    return ConstReverseIterator(begin());
+  }
+
+  ConstReverseIterator crbegin() const {    //NOLINT
+    return ConstReverseIterator(end());
+  }
+
+  ConstReverseIterator crend() const {    //NOLINT
+    return ConstReverseIterator(begin());
+  }
+};
+
+#endif
@@ -0,0 +1,106 @@
+#ifndef NODE_POOL_H
+#define NODE_POOL_H
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Fixed-size slot allocator for container nodes. Slots are carved out of geometrically
+// growing blocks and recycled through a free list, so once a container has reached its
+// working size, freeing and allocating nodes never reaches the global allocator.
+// Blocks are released only when the pool itself is destroyed.
+template <class T>
+class NodePool {
+  union Slot {
+    Slot *next;
+    alignas(T) unsigned char storage[sizeof(T)];
+  };
+
+  static constexpr size_t kFirstBlockSize = 16;
+  static constexpr size_t kMaxBlockSize = 1 << 16;
+
+  std::vector<std::unique_ptr<Slot[]> > blocks_;
+  Slot *free_ = nullptr;
+  size_t next_block_size_ = kFirstBlockSize;
+  size_t capacity_ = 0;
+
+  void AddBlock() {
+    blocks_.reserve(blocks_.size() + 1);
+    auto block = std::make_unique<Slot[]>(next_block_size_);
+    for (size_t i = 0; i < next_block_size_; ++i) {
+      block[i].next = i + 1 < next_block_size_ ? &block[i + 1] : free_;
+    }
+    free_ = &block[0];
+    capacity_ += next_block_size_;
+    blocks_.push_back(std::move(block));
+    next_block_size_ = std::min(next_block_size_ * 2, kMaxBlockSize);
+  }
+
+ public:
+  NodePool() = default;
+
+  NodePool(const NodePool &) = delete;
+  NodePool &operator=(const NodePool &) = delete;
+
+  NodePool(NodePool &&other) noexcept
+      : blocks_(std::move(other.blocks_)), free_(other.free_), next_block_size_(other.next_block_size_),
+        capacity_(other.capacity_) {
+    other.free_ = nullptr;
+    other.next_block_size_ = kFirstBlockSize;
+    other.capacity_ = 0;
+  }
+
+  NodePool &operator=(NodePool &&other) noexcept {
+    if (this != &other) {
+      blocks_ = std::move(other.blocks_);
+      free_ = other.free_;
+      next_block_size_ = other.next_block_size_;
+      capacity_ = other.capacity_;
+      other.free_ = nullptr;
+      other.next_block_size_ = kFirstBlockSize;
+      other.capacity_ = 0;
+    }
+    return *this;
+  }
+
+  void Reserve(size_t nodes) {
+    while (capacity_ < nodes) {
+      next_block_size_ = std::max(next_block_size_, std::min(nodes - capacity_, kMaxBlockSize));
+      AddBlock();
+    }
+  }
+
+  template <class... Args>
+  T *New(Args &&...args) {
+    if (free_ == nullptr) {
+      AddBlock();
+    }
+    Slot *slot = free_;
+    free_ = slot->next;
+    try {
+      return ::new (static_cast<void *>(slot->storage)) T(std::forward<Args>(args)...);
+    } catch (...) {
+      slot->next = free_;
+      free_ = slot;
+      throw;
+    }
+  }
+
+  void Delete(T *object) noexcept {
+    object->~T();
+    auto *slot = reinterpret_cast<Slot *>(object);
+    slot->next = free_;
+    free_ = slot;
+  }
+
+  [[nodiscard]] size_t Capacity() const {
+    return capacity_;
+  }
+
+  [[nodiscard]] size_t BytesReserved() const {
+    return capacity_ * sizeof(Slot);
+  }
+};
+
+#endif
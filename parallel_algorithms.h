@@ -0,0 +1,168 @@
+#ifndef PARALLEL_ALGORITHMS_H
+#define PARALLEL_ALGORITHMS_H
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <numeric>
+#include <optional>
+#include <type_traits>
+#include <vector>
+#include "thread_pool.h"
+#include "vector.h"
+
+// Parallel counterparts of std::fill, std::transform, std::reduce and std::sort over
+// random-access ranges such as Vector's, run on ThreadPool::Default(). Ranges shorter than
+// kParallelGrain elements are processed on the calling thread.
+inline constexpr size_t kParallelGrain = size_t{1} << 15;
+
+template <class RandomIt>
+inline constexpr bool kIsRandomAccess = std::is_base_of_v<std::random_access_iterator_tag,
+                                                          typename std::iterator_traits<RandomIt>::iterator_category>;
+
+template <class RandomIt, class T>
+void ParallelFill(RandomIt first, RandomIt last, const T &value) {
+  static_assert(kIsRandomAccess<RandomIt>, "ParallelFill needs random-access iterators");
+  ThreadPool::Default().ParallelFor(static_cast<size_t>(last - first), kParallelGrain, [&](size_t begin, size_t end) {
+    std::fill(first + begin, first + end, value);
+  });
+}
+
+template <class RandomIt, class OutputIt, class UnaryOp>
+OutputIt ParallelTransform(RandomIt first, RandomIt last, OutputIt out, UnaryOp op) {
+  static_assert(kIsRandomAccess<RandomIt> && kIsRandomAccess<OutputIt>,
+                "ParallelTransform needs random-access iterators");
+  const auto count = static_cast<size_t>(last - first);
+  ThreadPool::Default().ParallelFor(count, kParallelGrain, [&](size_t begin, size_t end) {
+    std::transform(first + begin, first + end, out + begin, op);
+  });
+  return out + count;
+}
+
+// Folds init with the elements through `op`, which must be associative. Pieces are reduced
+// in parallel and their results combined from left to right, so `op` need not commute.
+template <class RandomIt, class T, class BinaryOp = std::plus<> >
+T ParallelReduce(RandomIt first, RandomIt last, T init, BinaryOp op = BinaryOp()) {
+  static_assert(kIsRandomAccess<RandomIt>, "ParallelReduce needs random-access iterators");
+  const auto count = static_cast<size_t>(last - first);
+  ThreadPool &pool = ThreadPool::Default();
+  const size_t pieces = std::min((count + kParallelGrain - 1) / kParallelGrain, (pool.ThreadCount() + 1) * 4);
+  if (pieces <= 1) {
+    return std::accumulate(first, last, std::move(init), op);
+  }
+  std::vector<std::optional<T> > partials(pieces);
+  pool.ParallelFor(pieces, 1, [&](size_t piece_begin, size_t piece_end) {
+    for (size_t piece = piece_begin; piece < piece_end; ++piece) {
+      const size_t begin = count * piece / pieces;
+      const size_t end = count * (piece + 1) / pieces;
+      partials[piece].emplace(std::accumulate(first + begin + 1, first + end, T(first[begin]), op));
+    }
+  });
+  for (auto &partial : partials) {
+    init = op(std::move(init), std::move(*partial));
+  }
+  return init;
+}
+
+// How many of the first `taken` elements of a stable merge of sorted a[0, a_size) and
+// b[0, b_size) come from a.
+template <class ItA, class ItB, class Compare>
+size_t MergeSplit(ItA a, size_t a_size, ItB b, size_t b_size, size_t taken, Compare &comp) {
+  size_t low = taken > b_size ? taken - b_size : 0;
+  size_t high = std::min(taken, a_size);
+  while (low < high) {
+    const size_t from_a = low + (high - low) / 2;
+    if (comp(b[taken - from_a - 1], a[from_a])) {
+      high = from_a;
+    } else {
+      low = from_a + 1;
+    }
+  }
+  return low;
+}
+
+// Unstable parallel merge sort: the range is cut into a power-of-two number of runs that are
+// sorted concurrently and then merged pairwise, each merge split across threads at merge-path
+// boundaries. Merges alternate between the range and one buffer of the same size.
+template <class RandomIt, class Compare = std::less<> >
+void ParallelSort(RandomIt first, RandomIt last, Compare comp = Compare()) {
+  static_assert(kIsRandomAccess<RandomIt>, "ParallelSort needs random-access iterators");
+  using T = typename std::iterator_traits<RandomIt>::value_type;
+  const auto count = static_cast<size_t>(last - first);
+  ThreadPool &pool = ThreadPool::Default();
+  if (count < 2 * kParallelGrain || pool.ThreadCount() == 0) {
+    std::sort(first, last, comp);
+    return;
+  }
+  const size_t runs = std::min(std::bit_ceil(pool.ThreadCount() + 1), std::bit_floor(count / kParallelGrain));
+  const auto bound = [&](size_t run) { return count * run / runs; };
+  pool.ParallelFor(runs, 1, [&](size_t run_begin, size_t run_end) {
+    for (size_t run = run_begin; run < run_end; ++run) {
+      std::sort(first + bound(run), first + bound(run + 1), comp);
+    }
+  });
+
+  // Without a default constructor the buffer is built by moving the sorted runs into it, so
+  // the first round then merges from the buffer back into the range.
+  Vector<T> buffer;
+  bool in_buffer = false;
+  if constexpr (std::is_default_constructible_v<T>) {
+    buffer = Vector<T>(count, kDefaultInit);
+  } else {
+    buffer = Vector<T>(std::make_move_iterator(first), std::make_move_iterator(last));
+    in_buffer = true;
+  }
+
+  // Merges pairs of blocks of `width` runs from src into dst, as `runs` tasks. All split
+  // points are found before any element is moved, since the searches read across tasks.
+  std::vector<size_t> splits(runs);
+  const auto merge_round = [&](auto src, auto dst, size_t width) {
+    const size_t parts = 2 * width;
+    const auto output_begin = [&](size_t task) {
+      const size_t pair = task / parts;
+      return (bound((pair + 1) * parts) - bound(pair * parts)) * (task % parts) / parts;
+    };
+    pool.ParallelFor(runs, 1, [&](size_t task_begin, size_t task_end) {
+      for (size_t task = task_begin; task < task_end; ++task) {
+        const size_t pair = task / parts;
+        const size_t lo = bound(pair * parts);
+        const size_t mid = bound(pair * parts + width);
+        const size_t hi = bound((pair + 1) * parts);
+        splits[task] = MergeSplit(src + lo, mid - lo, src + mid, hi - mid, output_begin(task), comp);
+      }
+    });
+    pool.ParallelFor(runs, 1, [&](size_t task_begin, size_t task_end) {
+      for (size_t task = task_begin; task < task_end; ++task) {
+        const size_t pair = task / parts;
+        const bool last_part = task % parts == parts - 1;
+        const size_t lo = bound(pair * parts);
+        const size_t mid = bound(pair * parts + width);
+        const size_t hi = bound((pair + 1) * parts);
+        const size_t out_begin = output_begin(task);
+        const size_t out_end = last_part ? hi - lo : output_begin(task + 1);
+        const size_t a_begin = splits[task];
+        const size_t a_end = last_part ? mid - lo : splits[task + 1];
+        std::merge(std::make_move_iterator(src + lo + a_begin), std::make_move_iterator(src + lo + a_end),
+                   std::make_move_iterator(src + mid + (out_begin - a_begin)),
+                   std::make_move_iterator(src + mid + (out_end - a_end)), dst + lo + out_begin, comp);
+      }
+    });
+  };
+
+  for (size_t width = 1; width < runs; width *= 2) {
+    if (in_buffer) {
+      merge_round(buffer.begin(), first, width);
+    } else {
+      merge_round(first, buffer.begin(), width);
+    }
+    in_buffer = !in_buffer;
+  }
+  if (in_buffer) {
+    pool.ParallelFor(count, kParallelGrain, [&](size_t begin, size_t end) {
+      std::move(buffer.begin() + begin, buffer.begin() + end, first + begin);
+    });
+  }
+}
+
+#endif
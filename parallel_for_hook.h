@@ -0,0 +1,33 @@
+#ifndef PARALLEL_FOR_HOOK_H
+#define PARALLEL_FOR_HOOK_H
+
+#include <cstddef>
+
+// Lets containers split large element-wise work across threads without depending on a thread
+// pool. The runner calls piece(context, begin, end) over consecutive pieces of [0, count),
+// each at least `grain` long, and returns once all have run, rethrowing the first exception.
+// Nothing is installed by default, so the work runs on the calling thread; including
+// thread_pool.h installs ThreadPool::Default().
+class ParallelForHook {
+public:
+  using Piece = void (*)(void *context, std::size_t begin, std::size_t end);
+  using Runner = void (*)(std::size_t count, std::size_t grain, Piece piece, void *context);
+
+private:
+  static Runner &Installed() {
+    static Runner runner = nullptr;
+    return runner;
+  }
+
+public:
+  // Meant for static initialization, before other threads read the runner.
+  static void Install(Runner runner) {
+    Installed() = runner;
+  }
+
+  static Runner Get() {
+    return Installed();
+  }
+};
+
+#endif
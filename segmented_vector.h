@@ -0,0 +1,489 @@
+#ifndef SEGMENTED_VECTOR_H
+#define SEGMENTED_VECTOR_H
+
+#include <initializer_list>
+#include <algorithm>
+#include <stdexcept>
+#include <iterator>
+#include <bit>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include "vector.h"
+
+// Sequence stored in fixed chunks of ChunkSize elements, found through a Vector of chunk
+// pointers. Appending never moves an element, so pointers and references stay valid until the
+// element is erased, and growth costs one chunk allocation instead of an O(n) copy. Indexing
+// is a shift and a mask; iterators advance within a chunk and step to the next one at its end,
+// and ForEachSegment hands out whole chunks for loops that want contiguous runs.
+template<class T, std::size_t ChunkSize = std::max<std::size_t>(16, std::bit_floor(4096 / sizeof(T)))>
+class SegmentedVector {
+public:
+  using ValueType = T;
+  using Pointer = T *;
+  using ConstPointer = const T *;
+  using Reference = T &;
+  using ConstReference = const T &;
+  using SizeType = std::size_t;
+
+  static constexpr SizeType kChunkSize = ChunkSize;
+
+private:
+  static_assert(ChunkSize > 0 && (ChunkSize & (ChunkSize - 1)) == 0, "SegmentedVector chunks must be a power of two");
+
+  static constexpr SizeType kShift = std::countr_zero(ChunkSize);
+  static constexpr SizeType kMask = ChunkSize - 1;
+
+  Vector<Pointer> chunks_;
+  SizeType size_ = 0;
+
+public:
+  template<bool kConst>
+  class IteratorImpl {
+    friend class SegmentedVector;
+    template<bool>
+    friend class IteratorImpl;
+
+    Pointer const *chunk_ = nullptr;
+    SizeType offset_ = 0;
+
+    IteratorImpl(Pointer const *chunk, SizeType offset) : chunk_(chunk), offset_(offset) {
+    }
+
+  public:
+    using iterator_category = std::random_access_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = std::conditional_t<kConst, const T *, T *>;
+    using reference = std::conditional_t<kConst, const T &, T &>;
+
+    IteratorImpl() = default;
+
+    template<bool kOtherConst, class = std::enable_if_t<kConst && !kOtherConst> >
+    IteratorImpl(const IteratorImpl<kOtherConst> &other)  // NOLINT
+        : chunk_(other.chunk_), offset_(other.offset_) {
+    }
+
+    reference operator*() const {
+      return (*chunk_)[offset_];
+    }
+
+    pointer operator->() const {
+      return *chunk_ + offset_;
+    }
+
+    reference operator[](difference_type n) const {
+      return *(*this + n);
+    }
+
+    IteratorImpl &operator++() {
+      if (++offset_ == ChunkSize) {
+        ++chunk_;
+        offset_ = 0;
+      }
+      return *this;
+    }
+
+    IteratorImpl operator++(int) {
+      IteratorImpl copy = *this;
+      ++*this;
+      return copy;
+    }
+
+    IteratorImpl &operator--() {
+      if (offset_ == 0) {
+        --chunk_;
+        offset_ = ChunkSize;
+      }
+      --offset_;
+      return *this;
+    }
+
+    IteratorImpl operator--(int) {
+      IteratorImpl copy = *this;
+      --*this;
+      return copy;
+    }
+
+    IteratorImpl &operator+=(difference_type n) {
+      // Arithmetic shift, so that the chunk step rounds down for negative positions too.
+      const difference_type position = static_cast<difference_type>(offset_) + n;
+      chunk_ += position >> kShift;
+      offset_ = static_cast<SizeType>(position) & kMask;
+      return *this;
+    }
+
+    IteratorImpl &operator-=(difference_type n) {
+      return *this += -n;
+    }
+
+    friend IteratorImpl operator+(IteratorImpl it, difference_type n) {
+      return it += n;
+    }
+
+    friend IteratorImpl operator+(difference_type n, IteratorImpl it) {
+      return it += n;
+    }
+
+    friend IteratorImpl operator-(IteratorImpl it, difference_type n) {
+      return it -= n;
+    }
+
+    friend difference_type operator-(const IteratorImpl &a, const IteratorImpl &b) {
+      return (a.chunk_ - b.chunk_) * static_cast<difference_type>(ChunkSize)
+          + static_cast<difference_type>(a.offset_) - static_cast<difference_type>(b.offset_);
+    }
+
+    bool operator==(const IteratorImpl &other) const {
+      return chunk_ == other.chunk_ && offset_ == other.offset_;
+    }
+
+    bool operator!=(const IteratorImpl &other) const {
+      return !(*this == other);
+    }
+
+    bool operator<(const IteratorImpl &other) const {
+      return chunk_ < other.chunk_ || (chunk_ == other.chunk_ && offset_ < other.offset_);
+    }
+
+    bool operator<=(const IteratorImpl &other) const {
+      return !(other < *this);
+    }
+
+    bool operator>(const IteratorImpl &other) const {
+      return other < *this;
+    }
+
+    bool operator>=(const IteratorImpl &other) const {
+      return !(*this < other);
+    }
+  };
+
+  using Iterator = IteratorImpl<false>;
+  using ConstIterator = IteratorImpl<true>;
+  using ReverseIterator = std::reverse_iterator<Iterator>;
+  using ConstReverseIterator = std::reverse_iterator<ConstIterator>;
+
+private:
+  static Pointer AllocateChunk() {
+    return static_cast<Pointer>(::operator new(ChunkSize * sizeof(T), std::align_val_t{alignof(T)}));
+  }
+
+  static void DeallocateChunk(Pointer chunk) noexcept {
+    ::operator delete(chunk, std::align_val_t{alignof(T)});
+  }
+
+  // Where the next element goes; adds a chunk when every chunk is full.
+  Pointer NextSlot() {
+    if ((size_ >> kShift) == chunks_.Size()) {
+      Pointer chunk = AllocateChunk();
+      try {
+        chunks_.PushBack(chunk);
+      } catch (...) {
+        DeallocateChunk(chunk);
+        throw;
+      }
+    }
+    return chunks_[size_ >> kShift] + (size_ & kMask);
+  }
+
+  // Destroys the elements from index new_size on, chunk by chunk.
+  void Truncate(SizeType new_size) noexcept {
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      while (size_ > new_size) {
+        const SizeType chunk_begin = (size_ - 1) & ~kMask;
+        const SizeType from = std::max(chunk_begin, new_size);
+        std::destroy(chunks_[from >> kShift] + (from & kMask), chunks_[from >> kShift] + (size_ - chunk_begin));
+        size_ = from;
+      }
+    }
+    size_ = new_size;
+  }
+
+  void Release() noexcept {
+    Truncate(0);
+    for (Pointer chunk : chunks_) {
+      DeallocateChunk(chunk);
+    }
+    chunks_.Clear();
+  }
+
+  template<class ForwardIterator>
+  void AppendAll(ForwardIterator first, ForwardIterator last) {
+    try {
+      Reserve(size_ + static_cast<SizeType>(std::distance(first, last)));
+      for (; first != last; ++first) {
+        EmplaceBack(*first);
+      }
+    } catch (...) {
+      Release();
+      throw;
+    }
+  }
+
+public:
+  SegmentedVector() = default;
+
+  explicit SegmentedVector(SizeType size) {
+    try {
+      Resize(size);
+    } catch (...) {
+      Release();
+      throw;
+    }
+  }
+
+  explicit SegmentedVector(SizeType size, ConstReference value) {
+    try {
+      Resize(size, value);
+    } catch (...) {
+      Release();
+      throw;
+    }
+  }
+
+  template<class ForwardIterator, class = std::enable_if_t<std::is_base_of_v<std::forward_iterator_tag,
+    typename std::iterator_traits<ForwardIterator>::iterator_category> > >
+  explicit SegmentedVector(ForwardIterator first, ForwardIterator last) {
+    AppendAll(first, last);
+  }
+
+  SegmentedVector(std::initializer_list<ValueType> init) {
+    AppendAll(init.begin(), init.end());
+  }
+
+  SegmentedVector(const SegmentedVector &other) {
+    AppendAll(other.begin(), other.end());
+  }
+
+  SegmentedVector(SegmentedVector &&other) noexcept
+      : chunks_(std::move(other.chunks_)), size_(std::exchange(other.size_, 0)) {
+  }
+
+  SegmentedVector &operator=(const SegmentedVector &other) {
+    if (this != &other) {
+      SegmentedVector temp(other);
+      Swap(temp);
+    }
+    return *this;
+  }
+
+  SegmentedVector &operator=(SegmentedVector &&other) noexcept {
+    if (this != &other) {
+      Release();
+      Swap(other);
+    }
+    return *this;
+  }
+
+  ~SegmentedVector() {
+    Release();
+  }
+
+  [[nodiscard]] SizeType Size() const { return size_; }
+  [[nodiscard]] SizeType Capacity() const { return chunks_.Size() * ChunkSize; }
+  [[nodiscard]] bool Empty() const { return size_ == 0; }
+
+  const ValueType &operator[](SizeType i) const { return chunks_[i >> kShift][i & kMask]; }
+  ValueType &operator[](SizeType i) { return chunks_[i >> kShift][i & kMask]; }
+
+  const ValueType &At(SizeType i) const {
+    if (i >= size_) {
+      throw std::out_of_range("SegmentedVector::At");
+    }
+    return (*this)[i];
+  }
+
+  ValueType &At(SizeType i) {
+    if (i >= size_) {
+      throw std::out_of_range("SegmentedVector::At");
+    }
+    return (*this)[i];
+  }
+
+  const ValueType &Front() const {
+    return chunks_[0][0];
+  }
+
+  ValueType &Front() {
+    return chunks_[0][0];
+  }
+
+  const ValueType &Back() const {
+    return (*this)[size_ - 1];
+  }
+
+  ValueType &Back() {
+    return (*this)[size_ - 1];
+  }
+
+  // Calls f(data, count) for each run of contiguous elements, in order.
+  template<class F>
+  void ForEachSegment(F &&f) {
+    for (SizeType begin = 0; begin < size_; begin += ChunkSize) {
+      f(chunks_[begin >> kShift], std::min(ChunkSize, size_ - begin));
+    }
+  }
+
+  template<class F>
+  void ForEachSegment(F &&f) const {
+    for (SizeType begin = 0; begin < size_; begin += ChunkSize) {
+      f(static_cast<ConstPointer>(chunks_[begin >> kShift]), std::min(ChunkSize, size_ - begin));
+    }
+  }
+
+  void Swap(SegmentedVector &other) noexcept {
+    chunks_.Swap(other.chunks_);
+    std::swap(size_, other.size_);
+  }
+
+  // Destroys the elements but keeps the chunks for reuse.
+  void Clear() noexcept {
+    Truncate(0);
+  }
+
+  void Resize(const SizeType new_size) {
+    if (new_size <= size_) {
+      Truncate(new_size);
+      return;
+    }
+    Reserve(new_size);
+    while (size_ < new_size) {
+      new (NextSlot()) T();
+      ++size_;
+    }
+  }
+
+  void Resize(const SizeType new_size, ConstReference value) {
+    if (new_size <= size_) {
+      Truncate(new_size);
+      return;
+    }
+    Reserve(new_size);
+    while (size_ < new_size) {
+      new (NextSlot()) T(value);
+      ++size_;
+    }
+  }
+
+  // Allocates chunks up front; existing elements stay where they are.
+  void Reserve(const SizeType new_capacity) {
+    const SizeType chunk_count = (new_capacity + kMask) >> kShift;
+    if (chunk_count <= chunks_.Size()) {
+      return;
+    }
+    chunks_.Reserve(chunk_count);
+    while (chunks_.Size() < chunk_count) {
+      chunks_.PushBack(AllocateChunk());
+    }
+  }
+
+  // Frees the chunks past the last element.
+  void ShrinkToFit() {
+    const SizeType chunk_count = (size_ + kMask) >> kShift;
+    while (chunks_.Size() > chunk_count) {
+      DeallocateChunk(chunks_.Back());
+      chunks_.PopBack();
+    }
+    chunks_.ShrinkToFit();
+  }
+
+  void PushBack(ConstReference value) {
+    EmplaceBack(value);
+  }
+
+  void PushBack(T &&value) {
+    EmplaceBack(std::move(value));
+  }
+
+  // Returns the new element, whose address stays valid until it is erased.
+  template<typename... Args>
+  Reference EmplaceBack(Args &&... args) {
+    Pointer slot = NextSlot();
+    new (slot) T(std::forward<Args>(args)...);
+    ++size_;
+    return *slot;
+  }
+
+  void PopBack() {
+    if (size_ > 0) {
+      Truncate(size_ - 1);
+    }
+  }
+
+  bool operator==(const SegmentedVector &other) const {
+    return size_ == other.size_ && std::equal(begin(), end(), other.begin());
+  }
+
+  bool operator!=(const SegmentedVector &other) const {
+    return !(*this == other);
+  }
+
+  bool operator<(const SegmentedVector &other) const {
+    return std::lexicographical_compare(begin(), end(), other.begin(), other.end());
+  }
+
+  bool operator<=(const SegmentedVector &other) const {
+    return !(other < *this);
+  }
+
+  bool operator>(const SegmentedVector &other) const {
+    return other < *this;
+  }
+
+  bool operator>=(const SegmentedVector &other) const {
+    return !(*this < other);
+  }
+
+  Iterator begin() {    //NOLINT
+    return Iterator(chunks_.Data(), 0);
+  }
+
+  ConstIterator begin() const {    //NOLINT
+    return ConstIterator(chunks_.Data(), 0);
+  }
+
+  ConstIterator cbegin() const {    //NOLINT
+    return begin();
+  }
+
+  Iterator end() {    //NOLINT
+    return Iterator(chunks_.Data() + (size_ >> kShift), size_ & kMask);
+  }
+
+  ConstIterator end() const {    //NOLINT
+    return ConstIterator(chunks_.Data() + (size_ >> kShift), size_ & kMask);
+  }
+
+  ConstIterator cend() const {    //NOLINT
+    return end();
+  }
+
+  ReverseIterator rbegin() {    //NOLINT
+    return ReverseIterator(end());
+  }
+
+  ReverseIterator rend() {    //NOLINT
+    return ReverseIterator(begin());
+  }
+
+  ConstReverseIterator crbegin() const {    //NOLINT
+    return ConstReverseIterator(end());
+  }
+
+  ConstReverseIterator crend() const {    //NOLINT
+    return ConstReverseIterator(begin());
+  }
+
+  ConstReverseIterator rbegin() const {    //NOLINT
+    return ConstReverseIterator(end());
+  }
+
+  ConstReverseIterator rend() const {    //NOLINT
+    return ConstReverseIterator(begin());
+  }
+};
+
+#endif
@@ -0,0 +1,155 @@
+#ifndef SIMD_SEARCH_H
+#define SIMD_SEARCH_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Types whose operator== holds exactly when the object bytes are equal, so that runs of them
+// can be compared with memcmp or byte-wise SIMD. Holds for integers, enums and pointers; not
+// for floating point (NaN, -0.0). Specialize it to std::true_type for other types that qualify.
+template<class T>
+struct IsBitwiseComparable
+    : std::bool_constant<std::is_scalar_v<T> && std::has_unique_object_representations_v<T> > {};
+
+#ifdef __AVX2__
+// One bit per byte of the 32-byte block at `data`, set for the elements equal to `needle`
+// (which holds the value broadcast to every lane).
+template<class T>
+inline uint32_t EqualMask(const T *data, __m256i needle) {
+  const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data));
+  __m256i equal;
+  if constexpr (std::is_same_v<T, float>) {
+    equal = _mm256_castps_si256(_mm256_cmp_ps(_mm256_castsi256_ps(block), _mm256_castsi256_ps(needle), _CMP_EQ_OQ));
+  } else if constexpr (std::is_same_v<T, double>) {
+    equal = _mm256_castpd_si256(_mm256_cmp_pd(_mm256_castsi256_pd(block), _mm256_castsi256_pd(needle), _CMP_EQ_OQ));
+  } else if constexpr (sizeof(T) == 1) {
+    equal = _mm256_cmpeq_epi8(block, needle);
+  } else if constexpr (sizeof(T) == 2) {
+    equal = _mm256_cmpeq_epi16(block, needle);
+  } else if constexpr (sizeof(T) == 4) {
+    equal = _mm256_cmpeq_epi32(block, needle);
+  } else {
+    equal = _mm256_cmpeq_epi64(block, needle);
+  }
+  return static_cast<uint32_t>(_mm256_movemask_epi8(equal));
+}
+
+template<class T>
+inline __m256i Broadcast(T value) {
+  if constexpr (std::is_same_v<T, float>) {
+    return _mm256_castps_si256(_mm256_set1_ps(value));
+  } else if constexpr (std::is_same_v<T, double>) {
+    return _mm256_castpd_si256(_mm256_set1_pd(value));
+  } else if constexpr (sizeof(T) == 1) {
+    char bits;
+    std::memcpy(&bits, &value, 1);
+    return _mm256_set1_epi8(bits);
+  } else if constexpr (sizeof(T) == 2) {
+    int16_t bits;
+    std::memcpy(&bits, &value, 2);
+    return _mm256_set1_epi16(bits);
+  } else if constexpr (sizeof(T) == 4) {
+    int32_t bits;
+    std::memcpy(&bits, &value, 4);
+    return _mm256_set1_epi32(bits);
+  } else {
+    long long bits;
+    std::memcpy(&bits, &value, 8);
+    return _mm256_set1_epi64x(bits);
+  }
+}
+
+// Arithmetic types that EqualMask handles: floating point and exact integers of 1-8 bytes.
+template<class T>
+inline constexpr bool kSimdSearchable = std::is_arithmetic_v<T>
+    && (std::is_same_v<T, float> || std::is_same_v<T, double> || IsBitwiseComparable<T>::value)
+    && sizeof(T) <= 8;
+#endif
+
+// Index of the first element of data[0, size) equal to value, or size.
+template<class T>
+size_t FindEqual(const T *data, size_t size, const T &value) {
+  size_t i = 0;
+#ifdef __AVX2__
+  if constexpr (kSimdSearchable<T>) {
+    constexpr size_t kLanes = 32 / sizeof(T);
+    const __m256i needle = Broadcast(value);
+    for (; i + kLanes <= size; i += kLanes) {
+      if (const uint32_t mask = EqualMask(data + i, needle); mask != 0) {
+        return i + static_cast<size_t>(__builtin_ctz(mask)) / sizeof(T);
+      }
+    }
+  }
+#endif
+  for (; i < size; ++i) {
+    if (data[i] == value) {
+      return i;
+    }
+  }
+  return size;
+}
+
+template<class T>
+size_t CountEqual(const T *data, size_t size, const T &value) {
+  size_t count = 0;
+  size_t i = 0;
+#ifdef __AVX2__
+  if constexpr (kSimdSearchable<T>) {
+    constexpr size_t kLanes = 32 / sizeof(T);
+    const __m256i needle = Broadcast(value);
+    for (; i + kLanes <= size; i += kLanes) {
+      count += static_cast<size_t>(__builtin_popcount(EqualMask(data + i, needle))) / sizeof(T);
+    }
+  }
+#endif
+  for (; i < size; ++i) {
+    count += data[i] == value ? 1 : 0;
+  }
+  return count;
+}
+
+// Index of the first position where a and b differ, or size.
+template<class T>
+size_t FirstMismatch(const T *a, const T *b, size_t size) {
+  if constexpr (IsBitwiseComparable<T>::value) {
+    size_t i = 0;
+#ifdef __AVX2__
+    const auto *left = reinterpret_cast<const unsigned char *>(a);
+    const auto *right = reinterpret_cast<const unsigned char *>(b);
+    const size_t bytes = size * sizeof(T);
+    for (size_t offset = 0; offset + 32 <= bytes; offset += 32) {
+      const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(left + offset));
+      const __m256i y = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(right + offset));
+      const auto equal = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(x, y)));
+      if (equal != 0xFFFFFFFFu) {
+        return (offset + static_cast<size_t>(__builtin_ctz(~equal))) / sizeof(T);
+      }
+      i = (offset + 32) / sizeof(T);
+    }
+#else
+    // memcmp is vectorized by the C library; narrow down only once a block differs.
+    constexpr size_t kBlock = 256 / sizeof(T) > 0 ? 256 / sizeof(T) : 1;
+    for (; i + kBlock <= size; i += kBlock) {
+      if (std::memcmp(a + i, b + i, kBlock * sizeof(T)) != 0) {
+        break;
+      }
+    }
+#endif
+    for (; i < size; ++i) {
+      if (std::memcmp(a + i, b + i, sizeof(T)) != 0) {
+        return i;
+      }
+    }
+    return size;
+  } else {
+    return static_cast<size_t>(std::mismatch(a, a + size, b).first - a);
+  }
+}
+
+#endif
@@ -0,0 +1,430 @@
+#ifndef SMALL_VECTOR_H
+#define SMALL_VECTOR_H
+
+#include <initializer_list>
+#include <algorithm>
+#include <stdexcept>
+#include <iterator>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include "allocators.h"
+
+// Vector with room for N elements inside the object itself. The heap is used only once the
+// size grows past N; the buffer then doubles like Vector's and never returns to the inline
+// storage, except through ShrinkToFit.
+template<class T, std::size_t N = 8>
+class SmallVector {
+public:
+  using ValueType = T;
+  using Pointer = T *;
+  using ConstPointer = const T *;
+  using Reference = T &;
+  using ConstReference = const T &;
+  using SizeType = std::size_t;
+  using Iterator = Pointer;
+  using ConstIterator = ConstPointer;
+  using ReverseIterator = std::reverse_iterator<Iterator>;
+  using ConstReverseIterator = std::reverse_iterator<ConstIterator>;
+
+  static constexpr SizeType kInlineCapacity = N;
+
+private:
+  static_assert(N > 0, "SmallVector needs inline room for at least one element");
+
+  static constexpr bool kRelocatable = IsTriviallyRelocatable<T>::value;
+
+  SizeType size_ = 0;
+  SizeType capacity_ = N;
+  Pointer array_ = InlineData();
+  alignas(T) unsigned char inline_[N * sizeof(T)];
+
+  Pointer InlineData() {
+    return reinterpret_cast<Pointer>(inline_);
+  }
+
+  [[nodiscard]] bool IsInline() const {
+    return array_ == reinterpret_cast<ConstPointer>(inline_);
+  }
+
+  void ReleaseHeap() noexcept {
+    if (!IsInline()) {
+      ::operator delete(array_);
+    }
+  }
+
+  // Moves the elements into new_array, which holds capacity new_capacity and already has
+  // `tail` constructed elements from index size_ on. If a move throws, new_array is cleaned
+  // up (and released unless it is the inline buffer) and the vector is unchanged.
+  void AdoptBuffer(Pointer new_array, SizeType new_capacity, SizeType tail) {
+    if constexpr (kRelocatable) {
+      if (size_ > 0) {
+        std::memcpy(static_cast<void *>(new_array), static_cast<const void *>(array_), size_ * sizeof(T));
+      }
+    } else {
+      SizeType constructed = 0;
+      try {
+        for (; constructed < size_; ++constructed) {
+          new (new_array + constructed) T(std::move_if_noexcept(array_[constructed]));
+        }
+      } catch (...) {
+        std::destroy_n(new_array, constructed);
+        std::destroy_n(new_array + size_, tail);
+        if (new_array != InlineData()) {
+          ::operator delete(new_array);
+        }
+        throw;
+      }
+      std::destroy_n(array_, size_);
+    }
+    ReleaseHeap();
+    array_ = new_array;
+    capacity_ = new_capacity;
+  }
+
+  void Reallocate(SizeType new_capacity) {
+    if (new_capacity <= N) {
+      if (!IsInline()) {
+        AdoptBuffer(InlineData(), N, 0);
+      }
+      return;
+    }
+    AdoptBuffer(static_cast<Pointer>(::operator new(new_capacity * sizeof(T))), new_capacity, 0);
+  }
+
+  template<class... Args>
+  void GrowAndEmplaceBack(Args &&... args) {
+    const SizeType cap = capacity_ * 2;
+    Pointer new_array = static_cast<Pointer>(::operator new(cap * sizeof(T)));
+    try {
+      new (new_array + size_) T(std::forward<Args>(args)...);
+    } catch (...) {
+      ::operator delete(new_array);
+      throw;
+    }
+    AdoptBuffer(new_array, cap, 1);
+    ++size_;
+  }
+
+  // Used by constructors: makes room for `count` elements in a vector that holds none.
+  void AllocateFor(SizeType count) {
+    if (count > N) {
+      array_ = static_cast<Pointer>(::operator new(count * sizeof(T)));
+      capacity_ = count;
+    }
+  }
+
+  void ResetToInline() noexcept {
+    ReleaseHeap();
+    array_ = InlineData();
+    capacity_ = N;
+    size_ = 0;
+  }
+
+  // Steals a heap buffer or moves inline elements one by one; `other` is left empty.
+  void MoveFrom(SmallVector &other) {
+    if (!other.IsInline()) {
+      array_ = other.array_;
+      capacity_ = other.capacity_;
+      size_ = other.size_;
+      other.array_ = other.InlineData();
+      other.capacity_ = N;
+      other.size_ = 0;
+      return;
+    }
+    std::uninitialized_move_n(other.array_, other.size_, array_);
+    size_ = other.size_;
+    other.Clear();
+  }
+
+public:
+  SmallVector() = default;
+
+  explicit SmallVector(const SizeType size) {
+    AllocateFor(size);
+    try {
+      std::uninitialized_value_construct_n(array_, size);
+    } catch (...) {
+      ResetToInline();
+      throw;
+    }
+    size_ = size;
+  }
+
+  explicit SmallVector(SizeType size, ConstReference value) {
+    AllocateFor(size);
+    try {
+      std::uninitialized_fill_n(array_, size, value);
+    } catch (...) {
+      ResetToInline();
+      throw;
+    }
+    size_ = size;
+  }
+
+  template<class Iterator, class = std::enable_if_t<std::is_base_of_v<std::forward_iterator_tag,
+    typename std::iterator_traits<Iterator>::iterator_category> > >
+  explicit SmallVector(Iterator first, Iterator last) {
+    const auto size = static_cast<SizeType>(std::distance(first, last));
+    AllocateFor(size);
+    try {
+      std::uninitialized_copy(first, last, array_);
+    } catch (...) {
+      ResetToInline();
+      throw;
+    }
+    size_ = size;
+  }
+
+  SmallVector(std::initializer_list<ValueType> init) : SmallVector(init.begin(), init.end()) {
+  }
+
+  SmallVector(const SmallVector &other) : SmallVector(other.begin(), other.end()) {
+  }
+
+  SmallVector(SmallVector &&other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    MoveFrom(other);
+  }
+
+  SmallVector &operator=(const SmallVector &other) {
+    if (this != &other) {
+      SmallVector temp(other);
+      Clear();
+      ResetToInline();
+      MoveFrom(temp);
+    }
+    return *this;
+  }
+
+  SmallVector &operator=(SmallVector &&other) noexcept(std::is_nothrow_move_constructible_v<T>) {
+    if (this != &other) {
+      Clear();
+      ResetToInline();
+      MoveFrom(other);
+    }
+    return *this;
+  }
+
+  ~SmallVector() {
+    Clear();
+    ReleaseHeap();
+  }
+
+  [[nodiscard]] SizeType Size() const { return size_; }
+  [[nodiscard]] SizeType Capacity() const { return capacity_; }
+  [[nodiscard]] bool Empty() const { return size_ == 0; }
+  [[nodiscard]] bool IsSmall() const { return IsInline(); }
+
+  const ValueType &operator[](SizeType i) const { return array_[i]; }
+  ValueType &operator[](SizeType i) { return array_[i]; }
+
+  const ValueType &At(SizeType i) const {
+    if (i >= size_) {
+      throw std::out_of_range("SmallVector::At");
+    }
+    return array_[i];
+  }
+
+  ValueType &At(SizeType i) {
+    if (i >= size_) {
+      throw std::out_of_range("SmallVector::At");
+    }
+    return array_[i];
+  }
+
+  const ValueType &Front() const {
+    return array_[0];
+  }
+
+  ValueType &Front() {
+    return array_[0];
+  }
+
+  const ValueType &Back() const {
+    return array_[size_ - 1];
+  }
+
+  ValueType &Back() {
+    return array_[size_ - 1];
+  }
+
+  ConstPointer Data() const { return array_; }
+  Pointer Data() { return array_; }
+
+  void Swap(SmallVector &other) {
+    if (!IsInline() && !other.IsInline()) {
+      std::swap(size_, other.size_);
+      std::swap(capacity_, other.capacity_);
+      std::swap(array_, other.array_);
+      return;
+    }
+    SmallVector temp(std::move(other));
+    other = std::move(*this);
+    *this = std::move(temp);
+  }
+
+  void Clear() noexcept {
+    std::destroy(array_, array_ + size_);
+    size_ = 0;
+  }
+
+  void Resize(const SizeType new_size) {
+    if (new_size <= size_) {
+      std::destroy(array_ + new_size, array_ + size_);
+      size_ = new_size;
+      return;
+    }
+    if (new_size > capacity_) {
+      Reallocate(new_size);
+    }
+    std::uninitialized_value_construct_n(array_ + size_, new_size - size_);
+    size_ = new_size;
+  }
+
+  void Resize(const SizeType new_size, ConstReference value) {
+    if (new_size <= size_) {
+      std::destroy(array_ + new_size, array_ + size_);
+      size_ = new_size;
+    } else if (new_size <= capacity_) {
+      std::uninitialized_fill_n(array_ + size_, new_size - size_, value);
+      size_ = new_size;
+    } else {
+      // Filled before the elements move, since `value` may be one of them.
+      Pointer new_array = static_cast<Pointer>(::operator new(new_size * sizeof(T)));
+      try {
+        std::uninitialized_fill_n(new_array + size_, new_size - size_, value);
+      } catch (...) {
+        ::operator delete(new_array);
+        throw;
+      }
+      AdoptBuffer(new_array, new_size, new_size - size_);
+      size_ = new_size;
+    }
+  }
+
+  void Reserve(const SizeType new_capacity) {
+    if (new_capacity <= capacity_) {
+      return;
+    }
+    Reallocate(new_capacity);
+  }
+
+  // Moves the elements back inline when they fit.
+  void ShrinkToFit() {
+    if (IsInline() || capacity_ == size_) {
+      return;
+    }
+    Reallocate(size_);
+  }
+
+  void PushBack(ConstReference value) {
+    if (size_ < capacity_) {
+      std::construct_at(array_ + size_, value);
+      ++size_;
+      return;
+    }
+    GrowAndEmplaceBack(value);
+  }
+
+  void PushBack(T &&value) {
+    if (size_ < capacity_) {
+      std::construct_at(array_ + size_, std::move(value));
+      ++size_;
+      return;
+    }
+    GrowAndEmplaceBack(std::move(value));
+  }
+
+  template<typename... Args>
+  void EmplaceBack(Args &&... args) {
+    if (size_ < capacity_) {
+      new(array_ + size_) T(std::forward<Args>(args)...);
+      ++size_;
+      return;
+    }
+    GrowAndEmplaceBack(std::forward<Args>(args)...);
+  }
+
+  void PopBack() {
+    if (size_ > 0) {
+      std::destroy_at(array_ + size_ - 1);
+      --size_;
+    }
+  }
+
+  bool operator==(const SmallVector &other) const {
+    return std::equal(begin(), end(), other.begin(), other.end());
+  }
+
+  bool operator!=(const SmallVector &other) const {
+    return !(*this == other);
+  }
+
+  bool operator<(const SmallVector &other) const {
+    return std::lexicographical_compare(begin(), end(), other.begin(), other.end());
+  }
+
+  bool operator<=(const SmallVector &other) const {
+    return !(other < *this);
+  }
+
+  bool operator>(const SmallVector &other) const {
+    return other < *this;
+  }
+
+  bool operator>=(const SmallVector &other) const {
+    return !(*this < other);
+  }
+
+  Iterator begin() {    //NOLINT
+    return array_;
+  }
+
+  ConstIterator begin() const {    //NOLINT
+    return array_;
+  }
+
+  ConstIterator cbegin() const {    //NOLINT
+    return array_;
+  }
+
+  Iterator end() {    //NOLINT
+    return array_ + size_;
+  }
+
+  ConstIterator end() const {    //NOLINT
+    return array_ + size_;
+  }
+
+  ConstIterator cend() const {    //NOLINT
+    return array_ + size_;
+  }
+
+  ReverseIterator rbegin() {    //NOLINT
+    return ReverseIterator(end());
+  }
+
+  ReverseIterator rend() {    //NOLINT
+    return ReverseIterator(begin());
+  }
+
+  ConstReverseIterator crbegin() const {    //NOLINT
+    return ConstReverseIterator(end());
+  }
+
+  ConstReverseIterator crend() const {    //NOLINT
+    return ConstReverseIterator(begin());
+  }
+
+  ConstReverseIterator rbegin() const {    //NOLINT
+    return ConstReverseIterator(end());
+  }
+
+  ConstReverseIterator rend() const {    //NOLINT
+    return ConstReverseIterator(begin());
+  }
+};
+
+#endif
@@ -0,0 +1,220 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "parallel_for_hook.h"
+
+// Work-stealing pool. Every worker owns a deque: it pushes and pops its own tasks at the back
+// (depth first, which keeps nested splits cache-warm) and steals from the front of the
+// others' deques when its own runs dry. Threads that wait for tasks, including ones outside
+// the pool, run pending tasks meanwhile, so nested ParallelFor calls cannot deadlock.
+class ThreadPool {
+  struct Queue {
+    std::mutex mutex;
+    std::deque<std::function<void()> > tasks;
+  };
+
+  std::vector<std::unique_ptr<Queue> > queues_;
+  std::vector<std::thread> workers_;
+  std::atomic<size_t> queued_{0};
+  std::atomic<size_t> next_queue_{0};
+  std::mutex sleep_mutex_;
+  std::condition_variable wake_;
+  bool stopping_ = false;
+
+  // The pool and queue of the calling thread, when it is one of the workers.
+  static ThreadPool *&CurrentPool() {
+    static thread_local ThreadPool *pool = nullptr;
+    return pool;
+  }
+
+  static size_t &CurrentQueue() {
+    static thread_local size_t queue = 0;
+    return queue;
+  }
+
+  bool PopFrom(size_t index, bool back, std::function<void()> &task) {
+    Queue &queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      return false;
+    }
+    if (back) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      task = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    queued_.fetch_sub(1, std::memory_order_relaxed);
+    return true;
+  }
+
+  void WorkerLoop(size_t index) {
+    CurrentPool() = this;
+    CurrentQueue() = index;
+    while (true) {
+      if (RunPendingTask()) {
+        continue;
+      }
+      std::unique_lock<std::mutex> lock(sleep_mutex_);
+      wake_.wait(lock, [this] { return stopping_ || queued_.load(std::memory_order_relaxed) > 0; });
+      if (stopping_ && queued_.load(std::memory_order_relaxed) == 0) {
+        return;
+      }
+    }
+  }
+
+ public:
+  // `threads` workers; the threads that call ParallelFor work as well, hence one fewer than
+  // the hardware threads by default.
+  explicit ThreadPool(size_t threads = std::max(1u, std::thread::hardware_concurrency()) - 1) {
+    queues_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+      queues_.push_back(std::make_unique<Queue>());
+    }
+    workers_.reserve(threads);
+    for (size_t i = 0; i < threads; ++i) {
+      workers_.emplace_back([this, i] { WorkerLoop(i); });
+    }
+  }
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+      stopping_ = true;
+    }
+    wake_.notify_all();
+    for (auto &worker : workers_) {
+      worker.join();
+    }
+  }
+
+  // Pool shared by the library's parallel algorithms and large Vector copies.
+  static ThreadPool &Default() {
+    static ThreadPool pool;
+    return pool;
+  }
+
+  [[nodiscard]] size_t ThreadCount() const {
+    return workers_.size();
+  }
+
+  // Queues a task: on the caller's own deque for a worker, round robin otherwise. Requires at
+  // least one worker.
+  void Submit(std::function<void()> task) {
+    const size_t index = CurrentPool() == this ? CurrentQueue()
+                                              : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+      std::lock_guard<std::mutex> lock(queues_[index]->mutex);
+      queues_[index]->tasks.push_back(std::move(task));
+    }
+    queued_.fetch_add(1, std::memory_order_relaxed);
+    {
+      std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    wake_.notify_one();
+  }
+
+  // Runs one queued task, if there is any: the newest of the caller's own deque, or else the
+  // oldest of another one.
+  bool RunPendingTask() {
+    if (queued_.load(std::memory_order_relaxed) == 0) {
+      return false;
+    }
+    std::function<void()> task;
+    const bool is_worker = CurrentPool() == this;
+    const size_t start = is_worker ? CurrentQueue() : next_queue_.load(std::memory_order_relaxed);
+    if (is_worker && PopFrom(start, true, task)) {
+      task();
+      return true;
+    }
+    for (size_t i = 0; i < queues_.size(); ++i) {
+      if (PopFrom((start + i) % queues_.size(), false, task)) {
+        task();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  // Calls f(begin, end) over consecutive pieces of [0, count), each at least `grain` long
+  // unless count is smaller, and returns once all of them have run. The caller runs the first
+  // piece itself. The first exception thrown by a piece is rethrown here.
+  template <class F>
+  void ParallelFor(size_t count, size_t grain, F &&f) {
+    grain = std::max<size_t>(grain, 1);
+    const size_t pieces = std::min((count + grain - 1) / grain, (ThreadCount() + 1) * 4);
+    if (pieces <= 1 || ThreadCount() == 0) {
+      if (count > 0) {
+        f(size_t{0}, count);
+      }
+      return;
+    }
+    std::atomic<size_t> pending{0};
+    std::exception_ptr error;
+    std::mutex error_mutex;
+    const auto record_error = [&] {
+      std::lock_guard<std::mutex> lock(error_mutex);
+      if (!error) {
+        error = std::current_exception();
+      }
+    };
+    const auto run = [&](size_t piece) {
+      try {
+        f(count * piece / pieces, count * (piece + 1) / pieces);
+      } catch (...) {
+        record_error();
+      }
+    };
+    // The queued tasks refer to this frame, so even a failed Submit waits for the ones queued
+    // before it.
+    try {
+      for (size_t piece = 1; piece < pieces; ++piece) {
+        pending.fetch_add(1, std::memory_order_relaxed);
+        try {
+          Submit([&, piece] {
+            run(piece);
+            pending.fetch_sub(1, std::memory_order_release);
+          });
+        } catch (...) {
+          pending.fetch_sub(1, std::memory_order_relaxed);
+          throw;
+        }
+      }
+      run(0);
+    } catch (...) {
+      record_error();
+    }
+    while (pending.load(std::memory_order_acquire) > 0) {
+      if (!RunPendingTask()) {
+        std::this_thread::yield();
+      }
+    }
+    if (error) {
+      std::rethrow_exception(error);
+    }
+  }
+};
+
+// Runs the large copies and fills of Vector on the default pool.
+inline const bool kThreadPoolRunsVectorCopies = [] {
+  ParallelForHook::Install([](size_t count, size_t grain, ParallelForHook::Piece piece, void *context) {
+    ThreadPool::Default().ParallelFor(count, grain, [&](size_t begin, size_t end) { piece(context, begin, end); });
+  });
+  return true;
+}();
+
+#endif
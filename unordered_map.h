@@ -0,0 +1,141 @@
+#ifndef UNORDERED_MAP_H
+#define UNORDERED_MAP_H
+#include <stdexcept>
+#include <tuple>
+#include <utility>
+#include "hash_table.h"
+
+// Hash map on the same engine as UnorderedSet: pooled nodes holding std::pair<const Key, T>,
+// cached hashes, growth policies, statistics and the optional Bloom filter. Every insertion
+// hashes the key once and probes once; the mapped value is constructed in place in the node
+// only when the key is absent.
+template <class Key, class T, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>,
+          class GrowthPolicy = ExactGrowthPolicy>
+class UnorderedMap : public HashTable<Key, std::pair<const Key, T>, PairFirstKey, Hash, KeyEqual, GrowthPolicy> {
+  using Base = HashTable<Key, std::pair<const Key, T>, PairFirstKey, Hash, KeyEqual, GrowthPolicy>;
+  using typename Base::Node;
+
+  template <class K>
+  using EnableIfTransparent = typename Base::template EnableIfTransparent<K>;
+
+  template <class K, class... Args>
+  std::pair<Node *, bool> TryEmplaceImpl(K &&key, Args &&...args) {
+    const size_t hash = this->hash_(key);
+    return this->FindOrInsert(key, hash, std::piecewise_construct, std::forward_as_tuple(std::forward<K>(key)),
+                              std::forward_as_tuple(std::forward<Args>(args)...));
+  }
+
+  template <class K>
+  Node *FindPtrImpl(const K &key) const {
+    return this->LookupNode(key);
+  }
+
+ public:
+  using typename Base::ConstIterator;
+  using Iterator = typename Base::MutableIterator;
+  using ValueType = std::pair<const Key, T>;
+
+  using Base::Base;
+
+  // Inserts (key, T(args...)) if the key is absent; otherwise leaves both the map and `args`
+  // untouched.
+  template <class... Args>
+  std::pair<Iterator, bool> TryEmplace(const Key &key, Args &&...args) {
+    const auto [node, inserted] = TryEmplaceImpl(key, std::forward<Args>(args)...);
+    return {this->MakeMutableIterator(node), inserted};
+  }
+
+  template <class... Args>
+  std::pair<Iterator, bool> TryEmplace(Key &&key, Args &&...args) {
+    const auto [node, inserted] = TryEmplaceImpl(std::move(key), std::forward<Args>(args)...);
+    return {this->MakeMutableIterator(node), inserted};
+  }
+
+  template <class M>
+  std::pair<Iterator, bool> InsertOrAssign(const Key &key, M &&value) {
+    const auto [node, inserted] = TryEmplaceImpl(key, std::forward<M>(value));
+    if (!inserted) {
+      node->value.second = std::forward<M>(value);
+    }
+    return {this->MakeMutableIterator(node), inserted};
+  }
+
+  template <class M>
+  std::pair<Iterator, bool> InsertOrAssign(Key &&key, M &&value) {
+    const auto [node, inserted] = TryEmplaceImpl(std::move(key), std::forward<M>(value));
+    if (!inserted) {
+      node->value.second = std::forward<M>(value);
+    }
+    return {this->MakeMutableIterator(node), inserted};
+  }
+
+  std::pair<Iterator, bool> Insert(const ValueType &value) {
+    return TryEmplace(value.first, value.second);
+  }
+
+  template <class... Args>
+  std::pair<Iterator, bool> Emplace(Args &&...args) {
+    const auto [node, inserted] = this->EmplaceNode(std::forward<Args>(args)...);
+    return {this->MakeMutableIterator(node), inserted};
+  }
+
+  T &operator[](const Key &key) {
+    return TryEmplaceImpl(key).first->value.second;
+  }
+
+  T &operator[](Key &&key) {
+    return TryEmplaceImpl(std::move(key)).first->value.second;
+  }
+
+  // Pointer to the mapped value, or nullptr when the key is absent.
+  T *FindPtr(const Key &key) {
+    Node *node = FindPtrImpl(key);
+    return node == nullptr ? nullptr : &node->value.second;
+  }
+
+  const T *FindPtr(const Key &key) const {
+    const Node *node = FindPtrImpl(key);
+    return node == nullptr ? nullptr : &node->value.second;
+  }
+
+  template <class K, class = EnableIfTransparent<K> >
+  T *FindPtr(const K &key) {
+    Node *node = FindPtrImpl(key);
+    return node == nullptr ? nullptr : &node->value.second;
+  }
+
+  template <class K, class = EnableIfTransparent<K> >
+  const T *FindPtr(const K &key) const {
+    const Node *node = FindPtrImpl(key);
+    return node == nullptr ? nullptr : &node->value.second;
+  }
+
+  T &At(const Key &key) {
+    T *value = FindPtr(key);
+    if (value == nullptr) {
+      throw std::out_of_range("UnorderedMap::At");
+    }
+    return *value;
+  }
+
+  const T &At(const Key &key) const {
+    const T *value = FindPtr(key);
+    if (value == nullptr) {
+      throw std::out_of_range("UnorderedMap::At");
+    }
+    return *value;
+  }
+
+  using Base::begin;
+  using Base::end;
+
+  Iterator begin() {    //NOLINT
+    return this->MutableBegin();
+  }
+
+  Iterator end() {    //NOLINT
+    return this->MutableEnd();
+  }
+};
+
+#endif
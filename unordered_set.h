@@ -1,166 +1,114 @@
 #ifndef UNORDERED_SET_H
 #define UNORDERED_SET_H
-#include <list>
-#include <vector>
-#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "hash_table.h"
+#include "mapped_file.h"
+#include "unordered_set_snapshot.h"
 
-template <class Key>
-class UnorderedSet {
-  std::vector<std::list<Key> > baskets_;
-  size_t elements_count_ = 0;
+template <class Key, class Hash = std::hash<Key>, class KeyEqual = std::equal_to<Key>,
+          class GrowthPolicy = ExactGrowthPolicy>
+class UnorderedSet : public HashTable<Key, Key, IdentityKey, Hash, KeyEqual, GrowthPolicy> {
+  using Base = HashTable<Key, Key, IdentityKey, Hash, KeyEqual, GrowthPolicy>;
+  using typename Base::Node;
 
- public:
-  size_t Bucket(const Key &key) const {
-    return std::hash<Key>{}(key) % baskets_.size();
-  }
-
-  [[nodiscard]] size_t BucketCount() const {
-    if (baskets_.empty()) {
-      return 0;
-    }
-    return baskets_.size();
-  }
-
-  [[nodiscard]] size_t BucketSize(size_t id) const {
-    if (id < BucketCount()) {
-      return baskets_[id].size();
-    }
-    return 0;
-  }
-
-  [[nodiscard]] float LoadFactor() const {
-    if (baskets_.empty()) {
-      return 0.0f;
-    }
-    return static_cast<float>(elements_count_) / BucketCount();
-  }
-
-  void Rehash(const size_t new_bucket_count) {
-    if (new_bucket_count == BucketCount() || new_bucket_count < elements_count_) {
-      return;
-    }
-    std::vector<std::list<Key> > new_baskets(new_bucket_count);
-    for (auto bucket : baskets_) {
-      auto it = bucket.begin();
-      while (it != bucket.end()) {
-        size_t new_index = std::hash<Key>{}(*it) % new_bucket_count;
-        new_baskets[new_index].splice(new_baskets[new_index].end(), bucket, it++);
-      }
-    }
-    baskets_ = std::move(new_baskets);
-  }
-
-  UnorderedSet() = default;
-
-  explicit UnorderedSet(size_t bucket_count) : baskets_(bucket_count) {
-  }
-
-  template <class Forward>
-  UnorderedSet(Forward first, Forward last) {
-    if (first != last) {
-      baskets_.resize(std::distance(first, last));
-      for (auto it = first; it != last; ++it) {
-        Insert(*it);
-      }
-    }
-  }
+  template <class K>
+  using EnableIfTransparent = typename Base::template EnableIfTransparent<K>;
 
-  UnorderedSet(const UnorderedSet &other) {
-    baskets_ = other.baskets_;
-    elements_count_ = other.elements_count_;
+  template <class K>
+  std::pair<typename Base::ConstIterator, bool> InsertImpl(K &&key) {
+    const size_t hash = this->hash_(key);
+    const auto [node, inserted] = this->FindOrInsert(key, hash, std::forward<K>(key));
+    return {this->MakeIterator(node), inserted};
   }
 
-  UnorderedSet(UnorderedSet &&other) noexcept {
-    baskets_ = std::move(other.baskets_);
-    elements_count_ = other.elements_count_;
-    other.elements_count_ = 0;
-    other.baskets_.clear();
-  }
-
-  UnorderedSet &operator=(const UnorderedSet &other) {
-    if (this != &other) {
-      baskets_ = other.baskets_;
-      elements_count_ = other.elements_count_;
-    }
-    return *this;
-  }
-
-  UnorderedSet &operator=(UnorderedSet &&other) noexcept {
-    if (this != &other) {
-      baskets_ = std::move(other.baskets_);
-      elements_count_ = other.elements_count_;
-      other.baskets_.clear();
-      other.elements_count_ = 0;
-    }
-    return *this;
-  }
+ public:
+  using typename Base::ConstIterator;
+  using Iterator = ConstIterator;
 
-  [[nodiscard]] size_t Size() const {
-    return elements_count_;
-  }
+  using Base::Base;
 
-  [[nodiscard]] bool Empty() const {
-    return elements_count_ == 0;
+  std::pair<ConstIterator, bool> Insert(const Key &key) {
+    return InsertImpl(key);
   }
 
-  void Clear() {
-    for (auto basket : baskets_) {
-      basket.clear();
-    }
-    elements_count_ = 0;
+  std::pair<ConstIterator, bool> Insert(Key &&key) {
+    return InsertImpl(std::move(key));
   }
 
-  bool Find(const Key &key) const {
-    if (Empty()) {
-      return false;
-    }
-    size_t index = Bucket(key);
-    if (index >= baskets_.size()) {
-      return false;
-    }
-    auto &basket = baskets_[index];
-    return std::find(basket.begin(), basket.end(), key) != basket.end();
+  template <class K, class = EnableIfTransparent<K>, class = std::enable_if_t<std::is_constructible_v<Key, K &&> > >
+  std::pair<ConstIterator, bool> Insert(K &&key) {
+    return InsertImpl(std::forward<K>(key));
   }
 
-  void Insert(const Key &key) {
-    if (Find(key)) {
-      return;
-    }
-    if (elements_count_ >= BucketCount()) {
-      const size_t new_size = Empty() ? static_cast<size_t>(1) : BucketCount() * 2;
-      Rehash(new_size);
-    }
-    size_t index = Bucket(key);
-    baskets_[index].push_back(key);
-    ++elements_count_;
+  template <class... Args>
+  std::pair<ConstIterator, bool> Emplace(Args &&...args) {
+    const auto [node, inserted] = this->EmplaceNode(std::forward<Args>(args)...);
+    return {this->MakeIterator(node), inserted};
   }
 
-  void Insert(Key &&key) {
-    if (Find(key)) {
-      return;
+  // Writes the set in the layout that MappedUnorderedSet maps. The data goes to `path`.tmp,
+  // which is then renamed over `path`, so a reader never maps a half-written snapshot. Cached
+  // hashes are stored as is, so readers must use a Hash that yields the same values.
+  void SaveSnapshot(const std::string &path) const {
+    static_assert(std::is_trivially_copyable_v<Key>, "snapshots store keys as raw bytes");
+    const auto header = MakeSnapshotHeader<Key>(this->elements_count_);
+    std::vector<uint64_t> offsets(header.bucket_count + 1, 0);
+    for (size_t i = 0; i < this->baskets_.size(); ++i) {
+      for (const Node *node = this->Head(i); node != nullptr; node = node->next) {
+        ++offsets[SnapshotBucket(node->hash, header.bucket_count) + 1];
+      }
     }
-    if (elements_count_ >= BucketCount()) {
-      const size_t new_size = Empty() ? static_cast<size_t>(1) : BucketCount() * 2;
-      Rehash(new_size);
+    for (size_t i = 1; i < offsets.size(); ++i) {
+      offsets[i] += offsets[i - 1];
     }
-    size_t index = Bucket(key);
-    baskets_[index].push_back(std::move(key));
-    ++elements_count_;
-  }
-
-  void Erase(const Key &key) {
-    size_t index = Bucket(key);
-    auto &basket = baskets_[index];
-    auto it = std::find(basket.begin(), basket.end(), key);
-    if (it != basket.end()) {
-      basket.erase(it);
-      --elements_count_;
+    std::vector<const Node *> order(this->elements_count_);
+    {
+      std::vector<uint64_t> cursor(offsets.begin(), offsets.end() - 1);
+      for (size_t i = 0; i < this->baskets_.size(); ++i) {
+        for (const Node *node = this->Head(i); node != nullptr; node = node->next) {
+          order[cursor[SnapshotBucket(node->hash, header.bucket_count)]++] = node;
+        }
+      }
     }
-  }
-
-  void Reserve(size_t new_bucket_count) {
-    if (new_bucket_count > BucketCount()) {
-      Rehash(new_bucket_count);
+    const std::string temporary = path + ".tmp";
+    try {
+      FileDescriptor file(temporary, O_WRONLY | O_CREAT | O_TRUNC);
+      uint64_t position = 0;
+      auto write_at = [&](uint64_t offset, const void *data, size_t size) {
+        static constexpr char kZeros[kSnapshotAlignment] = {};
+        WriteAll(file.Get(), kZeros, offset - position);
+        WriteAll(file.Get(), data, size);
+        position = offset + size;
+      };
+      write_at(0, &header, sizeof(header));
+      write_at(header.offsets_offset, offsets.data(), offsets.size() * sizeof(uint64_t));
+      constexpr size_t kChunk = 1 << 14;
+      std::vector<char> buffer(kChunk * std::max(sizeof(Key), sizeof(uint64_t)));
+      for (size_t begin = 0; begin < order.size(); begin += kChunk) {
+        const size_t count = std::min(kChunk, order.size() - begin);
+        for (size_t i = 0; i < count; ++i) {
+          const uint64_t hash = order[begin + i]->hash;
+          std::memcpy(buffer.data() + i * sizeof(uint64_t), &hash, sizeof(uint64_t));
+        }
+        write_at(begin == 0 ? header.hashes_offset : position, buffer.data(), count * sizeof(uint64_t));
+      }
+      for (size_t begin = 0; begin < order.size(); begin += kChunk) {
+        const size_t count = std::min(kChunk, order.size() - begin);
+        for (size_t i = 0; i < count; ++i) {
+          std::memcpy(buffer.data() + i * sizeof(Key), &order[begin + i]->value, sizeof(Key));
+        }
+        write_at(begin == 0 ? header.keys_offset : position, buffer.data(), count * sizeof(Key));
+      }
+      write_at(header.file_size, nullptr, 0);
+    } catch (...) {
+      std::remove(temporary.c_str());
+      throw;
+    }
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+      std::remove(temporary.c_str());
+      throw MappedFileError("rename " + temporary + ": " + std::strerror(errno));
     }
   }
 };
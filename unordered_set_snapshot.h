@@ -0,0 +1,65 @@
+#ifndef UNORDERED_SET_SNAPSHOT_H
+#define UNORDERED_SET_SNAPSHOT_H
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include "hash_policy.h"
+
+// On-disk layout written by UnorderedSet::SaveSnapshot and read by MappedUnorderedSet:
+//
+//   header | bucket offsets (bucket_count + 1 x uint64) | hashes (size x uint64) | keys (size x Key)
+//
+// Every section starts at a multiple of kSnapshotAlignment. Entries are grouped by bucket, and
+// the entries of bucket b occupy [offsets[b], offsets[b + 1]). The bucket of a hash is
+// MixHash(hash) masked by the power-of-two bucket count, independent of the growth policy of
+// the set that wrote the file. The file is in native byte order.
+struct UnorderedSetSnapshotHeader {
+  static constexpr char kMagic[8] = {'U', 'S', 'E', 'T', 'S', 'N', 'P', '1'};
+
+  char magic[8];
+  uint64_t key_size;
+  uint64_t key_alignment;
+  uint64_t size;
+  uint64_t bucket_count;
+  uint64_t offsets_offset;
+  uint64_t hashes_offset;
+  uint64_t keys_offset;
+  uint64_t file_size;
+};
+
+constexpr size_t kSnapshotAlignment = 64;
+
+constexpr uint64_t AlignSnapshotOffset(uint64_t offset) {
+  return (offset + kSnapshotAlignment - 1) / kSnapshotAlignment * kSnapshotAlignment;
+}
+
+inline size_t SnapshotBucket(size_t hash, uint64_t bucket_count) {
+  return static_cast<size_t>(MixHash(hash) & (bucket_count - 1));
+}
+
+// Largest size whose layout fits in 64-bit offsets: the bucket offsets take at most 2 * size
+// entries, and the header, the offsets terminator and the padding less than 512 bytes.
+template <class Key>
+constexpr uint64_t kMaxSnapshotSize = (UINT64_MAX - 512) / (3 * sizeof(uint64_t) + sizeof(Key));
+
+template <class Key>
+UnorderedSetSnapshotHeader MakeSnapshotHeader(size_t size) {
+  static_assert(alignof(Key) <= kSnapshotAlignment);
+  if (size > kMaxSnapshotSize<Key>) {
+    throw std::length_error("MakeSnapshotHeader");
+  }
+  UnorderedSetSnapshotHeader header{};
+  std::memcpy(header.magic, UnorderedSetSnapshotHeader::kMagic, sizeof(header.magic));
+  header.key_size = sizeof(Key);
+  header.key_alignment = alignof(Key);
+  header.size = size;
+  header.bucket_count = PowerOfTwoGrowthPolicy::BucketCountFor(size);
+  header.offsets_offset = AlignSnapshotOffset(sizeof(UnorderedSetSnapshotHeader));
+  header.hashes_offset = AlignSnapshotOffset(header.offsets_offset + (header.bucket_count + 1) * sizeof(uint64_t));
+  header.keys_offset = AlignSnapshotOffset(header.hashes_offset + size * sizeof(uint64_t));
+  header.file_size = header.keys_offset + size * sizeof(Key);
+  return header;
+}
+
+#endif
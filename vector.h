@@ -6,11 +6,35 @@
 #include <algorithm>
 #include <stdexcept>
 #include <iterator>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include "allocators.h"
+#include "parallel_for_hook.h"
+#include "simd_search.h"
+#include "vector_stats.h"
+
+// Selects constructors that default-initialize instead of value-initialize: elements of
+// trivial types are left uninitialized for the caller to fill.
+struct DefaultInitTag {
+  explicit DefaultInitTag() = default;
+};
+
+inline constexpr DefaultInitTag kDefaultInit{};
 
-template<class T>
+// Allocator is any std-compatible allocator of T. Allocators that provide Reallocate (see
+// allocators.h) let trivially relocatable elements grow without a copy; the default
+// HeapAllocator does so with realloc. Elements are constructed in place directly, without
+// going through the allocator's construct and destroy. Stats is an instrumentation policy
+// (see vector_stats.h), e.g. TaggedVectorStats<"tag"> to count the buffer activity of a call
+// site; the default records nothing.
+template<class T, class Allocator = HeapAllocator<T>, class Stats = NoVectorStats>
 class Vector {
 public:
   using ValueType = T;
+  using AllocatorType = Allocator;
   using Pointer = T *;
   using ConstPointer = const T *;
   using Reference = T &;
@@ -22,91 +46,168 @@ public:
   using ConstReverseIterator = std::reverse_iterator<ConstIterator>;
 
 private:
+  using AllocatorTraits = std::allocator_traits<Allocator>;
+
+  // Relocatable elements move with memcpy, and with a Reallocate-capable allocator growth
+  // may extend the block in place (or remap its pages for large blocks) instead of copying.
+  static constexpr bool kRelocatable = IsTriviallyRelocatable<T>::value;
+  static constexpr bool kReallocatable = kRelocatable && HasReallocate<Allocator>::value;
+
   SizeType size_ = 0;
   SizeType capacity_ = 0;
   Pointer array_ = nullptr;
+  [[no_unique_address]] Allocator allocator_;
+  [[no_unique_address]] Stats stats_;
+
+  // A buffer that replaces an existing one is reported once, as a reallocation, by the caller
+  // that adopts it; only the first buffer counts as an allocation.
+  Pointer Allocate(SizeType count) {
+    Pointer array = AllocatorTraits::allocate(allocator_, count);
+    if (array_ == nullptr) {
+      stats_.OnAllocate(count * sizeof(T));
+    }
+    return array;
+  }
 
-public:
-  Vector() = default;
+  void Deallocate(Pointer array, SizeType count) noexcept {
+    if (array != nullptr) {
+      AllocatorTraits::deallocate(allocator_, array, count);
+    }
+  }
 
-  explicit Vector(const SizeType size) : size_(size), capacity_(size) {
-    if (capacity_ > 0) {
-      array_ = static_cast<T *>(::operator new(size_ * sizeof(T)));
+  // Moves the elements into new_array, which already holds `tail` constructed elements from
+  // index size_ on, and adopts it. If a move throws, new_array is released and the vector is
+  // unchanged.
+  void AdoptBuffer(Pointer new_array, SizeType new_capacity, SizeType tail) {
+    if constexpr (kRelocatable) {
+      if (size_ > 0) {
+        std::memcpy(static_cast<void *>(new_array), static_cast<const void *>(array_), size_ * sizeof(T));
+      }
+    } else {
+      SizeType constructed = 0;
       try {
-        std::uninitialized_value_construct_n(array_, size_);
+        for (; constructed < size_; ++constructed) {
+          new (new_array + constructed) T(std::move_if_noexcept(array_[constructed]));
+        }
       } catch (...) {
-        ::operator delete(array_);
-        array_ = nullptr;
-        size_ = 0;
-        capacity_ = 0;
+        std::destroy_n(new_array, constructed);
+        std::destroy_n(new_array + size_, tail);
+        Deallocate(new_array, new_capacity);
         throw;
       }
+      std::destroy_n(array_, size_);
+    }
+    if (array_ != nullptr) {
+      stats_.OnReallocate(new_capacity * sizeof(T), size_ * sizeof(T));
     }
+    Deallocate(array_, capacity_);
+    array_ = new_array;
+    capacity_ = new_capacity;
+  }
+
+  // Grows the buffer without moving it, when the allocator supports that (see TryExpand in
+  // allocators.h). Works for any element type, since nothing is relocated.
+  bool TryExpandInPlace(SizeType new_capacity) {
+    if constexpr (HasTryExpand<Allocator>::value) {
+      if (array_ != nullptr && allocator_.TryExpand(array_, capacity_, new_capacity)) {
+        stats_.OnReallocate(new_capacity * sizeof(T), 0);
+        capacity_ = new_capacity;
+        return true;
+      }
+    }
+    return false;
   }
 
-  explicit Vector(SizeType size, ConstReference value) : size_(size), capacity_(size) {
-    if (size > 0) {
-      array_ = static_cast<T *>(::operator new(size_ * sizeof(T)));
-      try {
-        std::uninitialized_fill_n(array_, size, value);
-      } catch (...) {
-        ::operator delete(array_);
-        array_ = nullptr;
-        size_ = 0;
-        capacity_ = 0;
-        throw;
-      }
+  // Capacity to allocate for `count` elements: the allocator may pad it (see GoodCapacity in
+  // allocators.h).
+  [[nodiscard]] SizeType CapacityFor(SizeType count) const {
+    if constexpr (HasGoodCapacity<Allocator>::value) {
+      return allocator_.GoodCapacity(count);
+    } else {
+      return count;
     }
   }
 
-  template<class Iterator, class = std::enable_if_t<std::is_base_of_v<std::forward_iterator_tag,
-    typename std::iterator_traits<Iterator>::iterator_category> > >
-  explicit Vector(Iterator first, Iterator last) : size_(std::distance(first, last)), capacity_(size_) {
-    try {
-      if (size_ > 0) {
-        array_ = static_cast<T *>(::operator new(size_ * sizeof(T)));
-        std::uninitialized_copy(first, last, array_);
+  // Moves the elements into a buffer of new_capacity >= size_ elements (padded by
+  // CapacityFor).
+  void Reallocate(SizeType new_capacity) {
+    new_capacity = CapacityFor(new_capacity);
+    if (new_capacity > capacity_ && TryExpandInPlace(new_capacity)) {
+      return;
+    }
+    if constexpr (kReallocatable) {
+      const bool had_buffer = array_ != nullptr;
+      array_ = allocator_.Reallocate(array_, capacity_, new_capacity);
+      // Counted as moved even though the allocator may have extended the block in place.
+      if (had_buffer) {
+        stats_.OnReallocate(new_capacity * sizeof(T), size_ * sizeof(T));
+      } else {
+        stats_.OnAllocate(new_capacity * sizeof(T));
       }
-    } catch (...) {
-      ::operator delete(array_);
-      array_ = nullptr;
-      size_ = 0;
-      capacity_ = 0;
-      throw;
+      capacity_ = new_capacity;
+    } else {
+      AdoptBuffer(Allocate(new_capacity), new_capacity, 0);
     }
   }
 
-  Vector(std::initializer_list<ValueType> init) : size_(init.size()), capacity_(size_), array_(nullptr) {
-    if (size_ != 0 && init.begin() != init.end()) {
-      array_ = static_cast<T *>(::operator new(size_ * sizeof(T)));
+  // Growth path of PushBack and EmplaceBack. The new element is built before the old buffer
+  // goes away, so `args` may refer to elements of this vector.
+  template<class... Args>
+  void GrowAndEmplaceBack(Args &&... args) {
+    const SizeType cap = CapacityFor(capacity_ == 0 ? 1 : capacity_ * 2);
+    if (TryExpandInPlace(cap)) {
+      new (array_ + size_) T(std::forward<Args>(args)...);
+    } else if constexpr (kReallocatable) {
+      T value(std::forward<Args>(args)...);
+      Reallocate(cap);
+      new (array_ + size_) T(std::move(value));
+    } else {
+      Pointer new_array = Allocate(cap);
       try {
-        std::uninitialized_copy(init.begin(), init.end(), array_);
+        new (new_array + size_) T(std::forward<Args>(args)...);
       } catch (...) {
-        ::operator delete(array_);
-        array_ = nullptr;
-        size_ = 0;
-        capacity_ = 0;
+        Deallocate(new_array, cap);
         throw;
       }
+      AdoptBuffer(new_array, cap, 1);
     }
+    ++size_;
   }
 
-  Vector(const Vector &other) : size_(other.size_), capacity_(other.capacity_) {
-    if (capacity_ > 0) {
-      array_ = static_cast<T *>(::operator new(size_ * sizeof(T)));
-      try {
-        std::uninitialized_copy(other.begin(), other.end(), array_);
-      } catch (...) {
-        ::operator delete(array_);
-        array_ = nullptr;
-        size_ = 0;
-        capacity_ = 0;
-        throw;
-      }
+  template<class Iterator>
+  static constexpr bool kIsForward = std::is_base_of_v<std::forward_iterator_tag,
+                                                       typename std::iterator_traits<Iterator>::iterator_category>;
+
+  // Whether `first` may point into this vector. Only pointer ranges are checked; ranges over
+  // this vector given by other iterator types are not supported by Append and Insert.
+  template<class Iterator>
+  bool PointsIntoThis(Iterator first) const {
+    if constexpr (std::is_pointer_v<Iterator>) {
+      return std::less_equal<ConstPointer>()(array_, first) && std::less<ConstPointer>()(first, array_ + size_);
+    } else {
+      return false;
+    }
+  }
+
+  // Capacity after growing to hold `required` elements: at least double, so that repeated
+  // bulk appends stay amortized O(1) per element.
+  [[nodiscard]] SizeType GrownCapacity(SizeType required) const {
+    return CapacityFor(std::max(capacity_ * 2, required));
+  }
+
+  // Frees everything; the vector is left empty without a buffer.
+  void Release() noexcept {
+    if (array_ != nullptr) {
+      stats_.OnRelease(size_ * sizeof(T), capacity_ * sizeof(T));
     }
+    std::destroy_n(array_, size_);
+    Deallocate(array_, capacity_);
+    array_ = nullptr;
+    size_ = 0;
+    capacity_ = 0;
   }
 
-  Vector(Vector &&other) noexcept {
+  void StealBuffer(Vector &other) noexcept {
     array_ = other.array_;
     size_ = other.size_;
     capacity_ = other.capacity_;
@@ -115,39 +216,147 @@ public:
     other.array_ = nullptr;
   }
 
+  // Copies and fills of at least kParallelBytes of trivially copyable elements are split
+  // through ParallelForHook in pieces of kParallelPieceBytes; they cannot throw, so no piece
+  // ever needs undoing.
+  static constexpr SizeType kParallelBytes = SizeType{1} << 24;
+  static constexpr SizeType kParallelPieceBytes = SizeType{1} << 20;
+
+  // Calls construct(begin, end) over [0, count), in parallel pieces when that pays off.
+  template<class Construct>
+  static void ConstructPieces(SizeType count, Construct &&construct) {
+    if (std::is_trivially_copyable_v<T> && count * sizeof(T) >= kParallelBytes) {
+      if (const ParallelForHook::Runner run = ParallelForHook::Get()) {
+        run(count, kParallelPieceBytes / sizeof(T), [](void *context, std::size_t begin, std::size_t end) {
+          (*static_cast<std::remove_reference_t<Construct> *>(context))(begin, end);
+        }, &construct);
+        return;
+      }
+    }
+    construct(SizeType{0}, count);
+  }
+
+  // Used by constructors: allocates room for `size` elements and lets `construct` fill them.
+  template<class Construct>
+  void InitWith(SizeType size, Construct &&construct) {
+    if (size == 0) {
+      return;
+    }
+    const SizeType capacity = CapacityFor(size);
+    array_ = Allocate(capacity);
+    try {
+      construct(array_);
+    } catch (...) {
+      Deallocate(array_, capacity);
+      array_ = nullptr;
+      throw;
+    }
+    size_ = size;
+    capacity_ = capacity;
+  }
+
+public:
+  Vector() = default;
+
+  explicit Vector(const Allocator &allocator) : allocator_(allocator) {
+  }
+
+  explicit Vector(const SizeType size, const Allocator &allocator = Allocator()) : allocator_(allocator) {
+    InitWith(size, [&](Pointer array) { std::uninitialized_value_construct_n(array, size); });
+  }
+
+  Vector(const SizeType size, DefaultInitTag, const Allocator &allocator = Allocator()) : allocator_(allocator) {
+    InitWith(size, [&](Pointer array) { std::uninitialized_default_construct_n(array, size); });
+  }
+
+  explicit Vector(SizeType size, ConstReference value, const Allocator &allocator = Allocator())
+      : allocator_(allocator) {
+    InitWith(size, [&](Pointer array) {
+      ConstructPieces(size, [&](SizeType begin, SizeType end) {
+        std::uninitialized_fill_n(array + begin, end - begin, value);
+      });
+    });
+  }
+
+  template<class Iterator, class = std::enable_if_t<std::is_base_of_v<std::forward_iterator_tag,
+    typename std::iterator_traits<Iterator>::iterator_category> > >
+  explicit Vector(Iterator first, Iterator last, const Allocator &allocator = Allocator()) : allocator_(allocator) {
+    const auto size = static_cast<SizeType>(std::distance(first, last));
+    InitWith(size, [&](Pointer array) {
+      if constexpr (std::is_same_v<Iterator, Pointer> || std::is_same_v<Iterator, ConstPointer>) {
+        ConstructPieces(size, [&](SizeType begin, SizeType end) {
+          std::uninitialized_copy(first + begin, first + end, array + begin);
+        });
+      } else {
+        std::uninitialized_copy(first, last, array);
+      }
+    });
+  }
+
+  Vector(std::initializer_list<ValueType> init, const Allocator &allocator = Allocator())
+      : Vector(init.begin(), init.end(), allocator) {
+  }
+
+  Vector(const Vector &other)
+      : Vector(other.begin(), other.end(), AllocatorTraits::select_on_container_copy_construction(other.allocator_)) {
+  }
+
+  Vector(const Vector &other, const Allocator &allocator) : Vector(other.begin(), other.end(), allocator) {
+  }
+
+  Vector(Vector &&other) noexcept : allocator_(std::move(other.allocator_)) {
+    StealBuffer(other);
+  }
+
   Vector &operator=(const Vector &other) {
     if (this != &other) {
-      if (other.capacity_ == 0) {
-        std::destroy_n(array_, size_);
-        ::operator delete(array_);
-        array_ = nullptr;
-        capacity_ = 0;
-        size_ = 0;
+      if constexpr (AllocatorTraits::propagate_on_container_copy_assignment::value) {
+        if (allocator_ != other.allocator_) {
+          Release();
+        }
+        allocator_ = other.allocator_;
+      }
+      if (other.size_ == 0) {
+        Release();
       } else {
-        Vector temp(other);
-        Swap(temp);
+        Vector temp(other, allocator_);
+        Release();
+        StealBuffer(temp);
       }
     }
     return *this;
   }
 
-  Vector &operator=(Vector &&other) noexcept {
+  // Steals the buffer when the allocator propagates or compares equal; otherwise the elements
+  // are moved one by one into memory from this vector's allocator.
+  Vector &operator=(Vector &&other) noexcept(AllocatorTraits::propagate_on_container_move_assignment::value ||
+                                             AllocatorTraits::is_always_equal::value) {
     if (this != &other) {
-      std::destroy_n(array_, size_);
-      ::operator delete(array_);
-      array_ = other.array_;
-      size_ = other.size_;
-      capacity_ = other.capacity_;
-      other.size_ = 0;
-      other.capacity_ = 0;
-      other.array_ = nullptr;
+      if constexpr (AllocatorTraits::propagate_on_container_move_assignment::value) {
+        Release();
+        allocator_ = std::move(other.allocator_);
+        StealBuffer(other);
+      } else {
+        if (allocator_ == other.allocator_) {
+          Release();
+          StealBuffer(other);
+        } else {
+          Vector temp(std::make_move_iterator(other.begin()), std::make_move_iterator(other.end()), allocator_);
+          Release();
+          StealBuffer(temp);
+          other.Release();
+        }
+      }
     }
     return *this;
   }
 
   ~Vector() {
-    Clear();
-    ::operator delete(array_);
+    Release();
+  }
+
+  [[nodiscard]] Allocator GetAllocator() const {
+    return allocator_;
   }
 
   [[nodiscard]] SizeType Size() const { return size_; }
@@ -191,9 +400,13 @@ public:
   Pointer Data() { return array_; }
 
   void Swap(Vector &other) {
+    if constexpr (AllocatorTraits::propagate_on_container_swap::value) {
+      std::swap(allocator_, other.allocator_);
+    }
     std::swap(size_, other.size_);
     std::swap(capacity_, other.capacity_);
     std::swap(array_, other.array_);
+    std::swap(stats_, other.stats_);
   }
 
   void Clear() noexcept {
@@ -212,31 +425,40 @@ public:
       size_ = new_size;
       return;
     }
-    if (new_size > size_ && new_size <= capacity_) {
-      std::uninitialized_value_construct_n(array_ + size_, new_size - size_);
+    if (new_size > capacity_) {
+      Reallocate(new_size);
+    }
+    std::uninitialized_value_construct_n(array_ + size_, new_size - size_);
+    size_ = new_size;
+  }
+
+  // Resize that default-initializes new elements, so trivial ones keep whatever bytes the
+  // buffer holds.
+  void ResizeDefaultInit(const SizeType new_size) {
+    if (new_size <= size_) {
+      std::destroy(array_ + new_size, array_ + size_);
       size_ = new_size;
       return;
     }
-    Pointer new_array = nullptr;
-    SizeType constructed = 0;
-    if (new_size > 0) {
-      try {
-        new_array = static_cast<T *>(::operator new(new_size * sizeof(T)));
-        for (; constructed < size_; ++constructed) {
-          new (new_array + constructed) T(std::move_if_noexcept(array_[constructed]));
-        }
-        std::uninitialized_value_construct_n(new_array + size_, new_size - size_);
-        std::destroy(array_, array_ + size_);
-        ::operator delete(array_);
-        array_ = new_array;
-        size_ = new_size;
-        capacity_ = new_size;
-      } catch (...) {
-        std::destroy_n(new_array, constructed);
-        ::operator delete(new_array);
-        throw;
-      }
+    if (new_size > capacity_) {
+      Reallocate(new_size);
     }
+    std::uninitialized_default_construct_n(array_ + size_, new_size - size_);
+    size_ = new_size;
+  }
+
+  // Grows the size to new_size without touching the new elements and returns a pointer to
+  // the first of them, e.g. as the target of a read(). Capacity grows geometrically, so a
+  // loop that extends the vector chunk by chunk stays amortized O(1) per element.
+  Pointer ReserveAndSetSize(const SizeType new_size) {
+    static_assert(std::is_trivially_default_constructible_v<T> && std::is_trivially_destructible_v<T>,
+                  "ReserveAndSetSize leaves elements unconstructed");
+    if (new_size > capacity_) {
+      Reallocate(GrownCapacity(new_size));
+    }
+    const SizeType old_size = std::min(size_, new_size);
+    size_ = new_size;
+    return array_ + old_size;
   }
 
   void Resize(const SizeType new_size, ConstReference value) {
@@ -248,37 +470,21 @@ public:
     if (new_size <= size_) {
       std::destroy(array_ + new_size, array_ + size_);
       size_ = new_size;
-    } else if (new_size > size_ && new_size <= capacity_) {
+    } else if (new_size <= capacity_ || TryExpandInPlace(new_size)) {
       std::uninitialized_fill_n(array_ + size_, new_size - size_, value);
       size_ = new_size;
     } else {
-      Pointer new_array = nullptr;
-      SizeType constructed = 0;
-      if (new_size > 0) {
-        try {
-          new_array = static_cast<T *>(::operator new(new_size * sizeof(T)));
-          for (; constructed < size_; ++constructed) {
-            new (new_array + constructed) T(std::move_if_noexcept(array_[constructed]));
-          }
-          std::uninitialized_fill_n(new_array + size_, new_size - size_, value);
-          std::destroy(array_, array_ + size_);
-          ::operator delete(array_);
-          array_ = new_array;
-          size_ = new_size;
-          capacity_ = new_size;
-        } catch (...) {
-          std::destroy_n(new_array, constructed);
-          ::operator delete(new_array);
-          throw;
-        }
-      } else {
-        Clear();
-        std::destroy(array_, array_ + size_);
-        ::operator delete(array_);
-        array_ = nullptr;
-        size_ = 0;
-        capacity_ = 0;
+      // Filled before the elements move, since `value` may be one of them.
+      const SizeType cap = CapacityFor(new_size);
+      Pointer new_array = Allocate(cap);
+      try {
+        std::uninitialized_fill_n(new_array + size_, new_size - size_, value);
+      } catch (...) {
+        Deallocate(new_array, cap);
+        throw;
       }
+      AdoptBuffer(new_array, cap, new_size - size_);
+      size_ = new_size;
     }
   }
 
@@ -287,48 +493,17 @@ public:
     if (new_capacity <= capacity_) {
       return;
     }
-    Pointer new_array = nullptr;
-    SizeType constructed = 0;
-    try {
-      new_array = static_cast<T *>(::operator new(new_capacity * sizeof(T)));
-      for (; constructed < size_; ++constructed) {
-        new (new_array + constructed) T(std::move_if_noexcept(array_[constructed]));
-      }
-      capacity_ = new_capacity;
-      std::destroy(array_, array_ + size_);
-      ::operator delete(array_);
-      array_ = new_array;
-    } catch (...) {
-      std::destroy(new_array, new_array + size_);
-      ::operator delete(new_array);
-      throw;
-    }
+    Reallocate(new_capacity);
   }
 
 
   void ShrinkToFit() {
     if (size_ == 0) {
-      ::operator delete(array_);
-      array_ = nullptr;
-      size_ = 0;
-      capacity_ = 0;
+      Release();
       return;
     }
-    Pointer new_array = nullptr;
-    SizeType constructed = 0;
-    try {
-      new_array = static_cast<T *>(::operator new(size_ * sizeof(T)));
-      for (; constructed < size_; ++constructed) {
-        new (new_array + constructed) T(std::move_if_noexcept(array_[constructed]));
-      }
-      std::destroy(array_, array_ + size_);
-      ::operator delete(array_);
-      array_ = new_array;
-      capacity_ = size_;
-    } catch (...) {
-      std::destroy(new_array, new_array + constructed);
-      ::operator delete(new_array);
-      throw;
+    if (capacity_ != CapacityFor(size_)) {
+      Reallocate(size_);
     }
   }
 
@@ -338,25 +513,7 @@ public:
       ++size_;
       return;
     }
-    Pointer new_array = nullptr;
-    SizeType constructed = 0;
-    try {
-      const SizeType cap = capacity_ == 0 ? 1 : capacity_ * 2;
-      new_array = static_cast<T *>(::operator new(cap * sizeof(T)));
-      for (; constructed < size_; ++constructed) {
-        new (new_array + constructed) T(std::move(array_[constructed]));
-      }
-      std::construct_at(new_array + size_, value);
-      std::destroy(array_, array_ + size_);
-      ::operator delete(array_);
-      array_ = new_array;
-      ++size_;
-      capacity_ = cap;
-    } catch (...) {
-      std::destroy(new_array, new_array + constructed);
-      ::operator delete(new_array);
-      throw;
-    }
+    GrowAndEmplaceBack(value);
   }
 
   void PushBack(T &&value) {
@@ -365,25 +522,7 @@ public:
       ++size_;
       return;
     }
-    Pointer new_array = nullptr;
-    SizeType constructed = 0;
-    try {
-      const SizeType cap = capacity_ == 0 ? 1 : capacity_ * 2;
-      new_array = static_cast<T *>(::operator new(cap * sizeof(T)));
-      for (; constructed < size_; ++constructed) {
-        new (new_array + constructed) T(std::move(array_[constructed]));
-      }
-      std::construct_at(new_array + size_, std::move(value));
-      std::destroy(array_, array_ + size_);
-      ::operator delete(array_);
-      array_ = new_array;
-      ++size_;
-      capacity_ = cap;
-    } catch (...) {
-      std::destroy(new_array, new_array + constructed);
-      ::operator delete(new_array);
-      throw;
-    }
+    GrowAndEmplaceBack(std::move(value));
   }
 
   void PopBack() {
@@ -393,10 +532,186 @@ public:
     }
   }
 
+  // Copies [first, last) to the end, reallocating at most once for forward ranges.
+  template<class InputIterator>
+  void Append(InputIterator first, InputIterator last) {
+    if constexpr (!kIsForward<InputIterator>) {
+      for (; first != last; ++first) {
+        EmplaceBack(*first);
+      }
+    } else {
+      const auto count = static_cast<SizeType>(std::distance(first, last));
+      const SizeType cap = GrownCapacity(size_ + count);
+      if (size_ + count <= capacity_ || TryExpandInPlace(cap)) {
+        std::uninitialized_copy(first, last, array_ + size_);
+        size_ += count;
+        return;
+      }
+      if constexpr (kReallocatable) {
+        if (!PointsIntoThis(first)) {
+          Reallocate(cap);
+          std::uninitialized_copy(first, last, array_ + size_);
+          size_ += count;
+          return;
+        }
+      }
+      // The new elements are built before the old buffer goes away, since the range may
+      // point into it.
+      Pointer new_array = Allocate(cap);
+      try {
+        std::uninitialized_copy(first, last, new_array + size_);
+      } catch (...) {
+        Deallocate(new_array, cap);
+        throw;
+      }
+      AdoptBuffer(new_array, cap, count);
+      size_ += count;
+    }
+  }
+
+  // Inserts copies of [first, last) before `pos` and returns an iterator to the first of
+  // them. Relocatable elements are shifted with one memmove; others are appended and rotated
+  // into place.
+  template<class ForwardIterator, class = std::enable_if_t<std::is_base_of_v<std::forward_iterator_tag,
+    typename std::iterator_traits<ForwardIterator>::iterator_category> > >
+  Iterator Insert(ConstIterator pos, ForwardIterator first, ForwardIterator last) {
+    const auto index = static_cast<SizeType>(pos - array_);
+    const auto count = static_cast<SizeType>(std::distance(first, last));
+    if (count == 0) {
+      return array_ + index;
+    }
+    if constexpr (kRelocatable) {
+      if (PointsIntoThis(first)) {
+        Vector copy(first, last, allocator_);
+        return Insert(pos, std::make_move_iterator(copy.begin()), std::make_move_iterator(copy.end()));
+      }
+      if (size_ + count > capacity_) {
+        Reallocate(GrownCapacity(size_ + count));
+      }
+      Pointer gap = array_ + index;
+      const SizeType tail = size_ - index;
+      if (tail > 0) {
+        std::memmove(static_cast<void *>(gap + count), static_cast<const void *>(gap), tail * sizeof(T));
+      }
+      try {
+        std::uninitialized_copy(first, last, gap);
+      } catch (...) {
+        if (tail > 0) {
+          std::memmove(static_cast<void *>(gap), static_cast<const void *>(gap + count), tail * sizeof(T));
+        }
+        throw;
+      }
+      size_ += count;
+    } else {
+      const SizeType old_size = size_;
+      Append(first, last);
+      std::rotate(array_ + index, array_ + old_size, array_ + size_);
+    }
+    return array_ + index;
+  }
+
+  Iterator Erase(ConstIterator pos) {
+    return Erase(pos, pos + 1);
+  }
+
+  // Removes [first, last) and returns an iterator to the element that followed it.
+  Iterator Erase(ConstIterator first, ConstIterator last) {
+    Pointer from = array_ + (first - array_);
+    Pointer to = array_ + (last - array_);
+    if (from == to) {
+      return from;
+    }
+    const auto tail = static_cast<SizeType>(array_ + size_ - to);
+    if constexpr (kRelocatable) {
+      std::destroy(from, to);
+      if (tail > 0) {
+        std::memmove(static_cast<void *>(from), static_cast<const void *>(to), tail * sizeof(T));
+      }
+    } else {
+      std::move(to, array_ + size_, from);
+      std::destroy(from + tail, array_ + size_);
+    }
+    size_ -= static_cast<SizeType>(to - from);
+    return from;
+  }
+
+  // Removes every element matching `predicate` in one pass; returns how many were removed.
+  template<class Predicate>
+  SizeType EraseIf(Predicate predicate) {
+    const SizeType old_size = size_;
+    Erase(std::remove_if(begin(), end(), predicate), end());
+    return old_size - size_;
+  }
+
+  // Replaces the contents with [first, last), reusing the current elements and buffer when
+  // the range fits.
+  template<class ForwardIterator, class = std::enable_if_t<std::is_base_of_v<std::forward_iterator_tag,
+    typename std::iterator_traits<ForwardIterator>::iterator_category> > >
+  void Assign(ForwardIterator first, ForwardIterator last) {
+    const auto count = static_cast<SizeType>(std::distance(first, last));
+    if (count > capacity_) {
+      Vector temp(first, last, allocator_);
+      Release();
+      StealBuffer(temp);
+      return;
+    }
+    if (count <= size_) {
+      Pointer new_end = std::copy(first, last, array_);
+      std::destroy(new_end, array_ + size_);
+    } else {
+      ForwardIterator middle = std::next(first, static_cast<std::ptrdiff_t>(size_));
+      std::copy(first, middle, array_);
+      std::uninitialized_copy(middle, last, array_ + size_);
+    }
+    size_ = count;
+  }
+
+  void Assign(SizeType count, ConstReference value) {
+    if (count > capacity_) {
+      Vector temp(count, value, allocator_);
+      Release();
+      StealBuffer(temp);
+      return;
+    }
+    if (count <= size_) {
+      std::fill_n(array_, count, value);
+      std::destroy(array_ + count, array_ + size_);
+    } else {
+      std::fill_n(array_, size_, value);
+      std::uninitialized_fill_n(array_ + size_, count - size_, value);
+    }
+    size_ = count;
+  }
+
+  void Assign(std::initializer_list<ValueType> init) {
+    Assign(init.begin(), init.end());
+  }
+
+  // Iterator to the first element equal to value, or end(). Vectorized for arithmetic types
+  // when built with AVX2.
+  Iterator Find(ConstReference value) {
+    return array_ + FindEqual(array_, size_, value);
+  }
+
+  ConstIterator Find(ConstReference value) const {
+    return array_ + FindEqual(array_, size_, value);
+  }
+
+  [[nodiscard]] SizeType Count(ConstReference value) const {
+    return CountEqual(array_, size_, value);
+  }
+
+  [[nodiscard]] bool Contains(ConstReference value) const {
+    return FindEqual(array_, size_, value) != size_;
+  }
+
   bool operator==(const Vector &other) const {
     if (size_ != other.size_) {
       return false;
     }
+    if constexpr (IsBitwiseComparable<T>::value) {
+      return size_ == 0 || std::memcmp(array_, other.array_, size_ * sizeof(T)) == 0;
+    }
     for (SizeType i = 0; i < size_; ++i) {
       if (array_[i] != other.array_[i]) {
         return false;
@@ -405,12 +720,16 @@ public:
     return true;
   }
 
-
   bool operator!=(const Vector &other) const {
     return !(*this == other);
   }
 
   bool operator<(const Vector &other) const {
+    if constexpr (IsBitwiseComparable<T>::value) {
+      const SizeType common = std::min(size_, other.size_);
+      const SizeType i = FirstMismatch(array_, other.array_, common);
+      return i < common ? array_[i] < other.array_[i] : size_ < other.size_;
+    }
     for (SizeType i = 0; i < size_ && i < other.size_; ++i) {
       if (array_[i] != other.array_[i]) {
         return array_[i] < other.array_[i];
@@ -486,26 +805,17 @@ public:
       ++size_;
       return;
     }
-    Pointer new_array = nullptr;
-    SizeType constructed = 0;
-    try {
-      const SizeType cap = capacity_ == 0 ? 1 : capacity_ * 2;
-      new_array = static_cast<T *>(::operator new(cap * sizeof(T)));
-      for (; constructed < size_; ++constructed) {
-        new (new_array + constructed) T(std::move_if_noexcept(array_[constructed]));
-      }
-      std::destroy(array_, array_ + size_);
-      ::operator delete(array_);
-      array_ = new_array;
-      capacity_ = cap;
-    } catch (...) {
-      std::destroy(new_array, new_array + size_);
-      ::operator delete(new_array);
-      throw;
-    }
-    new(array_ + size_) T(std::forward<Args>(args)...);
-    ++size_;
+    GrowAndEmplaceBack(std::forward<Args>(args)...);
   }
 };
 
+// Vector<T, Align<N> > keeps its elements in a buffer aligned to N bytes, with the capacity
+// padded to whole N-byte blocks, so SIMD loops over Data() need no peeling and may read
+// the last block in full.
+template<class T, std::size_t N, class Stats>
+class Vector<T, Align<N>, Stats> : public Vector<T, AlignedAllocator<T, N>, Stats> {
+public:
+  using Vector<T, AlignedAllocator<T, N>, Stats>::Vector;
+};
+
 #endif
@@ -0,0 +1,98 @@
+#ifndef VECTOR_FILE_H
+#define VECTOR_FILE_H
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include "mapped_file.h"
+#include "vector.h"
+
+// Record written by WriteVector and read by ReadVector and MappedVector:
+//
+//   header | padding up to data_offset | elements (size x T)
+//
+// data_offset is a multiple of kVectorFileAlignment, so a mapped record that starts on a page
+// boundary keeps its elements aligned. The record is in native byte order.
+struct VectorFileHeader {
+  static constexpr char kMagic[8] = {'V', 'E', 'C', 'T', 'O', 'R', '0', '1'};
+
+  char magic[8];
+  uint64_t element_size;
+  uint64_t element_alignment;
+  uint64_t size;
+  uint64_t data_offset;
+};
+
+constexpr size_t kVectorFileAlignment = 64;
+
+template <class T>
+VectorFileHeader MakeVectorFileHeader(size_t size) {
+  static_assert(alignof(T) <= kVectorFileAlignment);
+  VectorFileHeader header{};
+  std::memcpy(header.magic, VectorFileHeader::kMagic, sizeof(header.magic));
+  header.element_size = sizeof(T);
+  header.element_alignment = alignof(T);
+  header.size = size;
+  header.data_offset = (sizeof(VectorFileHeader) + kVectorFileAlignment - 1) / kVectorFileAlignment * kVectorFileAlignment;
+  return header;
+}
+
+// Checks a header read from `source` (a path or a call name, for the error message).
+template <class T>
+void ValidateVectorFileHeader(const VectorFileHeader &header, const std::string &source) {
+  if (std::memcmp(header.magic, VectorFileHeader::kMagic, sizeof(header.magic)) != 0) {
+    throw MappedFileError(source + ": not a Vector record");
+  }
+  if (header.element_size != sizeof(T) || header.element_alignment != alignof(T)) {
+    throw MappedFileError(source + ": record was written for a different element type");
+  }
+  const auto expected = MakeVectorFileHeader<T>(header.size);
+  if (std::memcmp(&expected, &header, sizeof(header)) != 0) {
+    throw MappedFileError(source + ": corrupt record header");
+  }
+}
+
+// Writes the elements of `vector` as one record at the current position of fd: the header,
+// then all elements in a single write. Throws MappedFileError on failure.
+template<class T, class Allocator, class Stats>
+void WriteVector(int fd, const Vector<T, Allocator, Stats> &vector) {
+  static_assert(std::is_trivially_copyable_v<T>, "Vector records store elements as raw bytes");
+  const auto header = MakeVectorFileHeader<T>(vector.Size());
+  char prefix[kVectorFileAlignment] = {};
+  std::memcpy(prefix, &header, sizeof(header));
+  WriteAll(fd, prefix, header.data_offset);
+  if (!vector.Empty()) {
+    WriteAll(fd, vector.Data(), vector.Size() * sizeof(T));
+  }
+}
+
+// Replaces the elements of `vector` with the record at the current position of fd, read
+// straight into its buffer. Throws MappedFileError on failure or on a record of another
+// element type; the vector is then left empty.
+template<class T, class Allocator, class Stats>
+void ReadVector(int fd, Vector<T, Allocator, Stats> &vector) {
+  static_assert(std::is_trivially_copyable_v<T>, "Vector records store elements as raw bytes");
+  char prefix[kVectorFileAlignment];
+  VectorFileHeader header;
+  vector.Clear();
+  ReadAll(fd, &header, sizeof(header));
+  ValidateVectorFileHeader<T>(header, "ReadVector");
+  ReadAll(fd, prefix, header.data_offset - sizeof(header));
+  if (header.size > SIZE_MAX / sizeof(T)) {
+    throw MappedFileError("ReadVector: record too large");
+  }
+  const auto size = static_cast<size_t>(header.size);
+  // Cleared first, so a bigger buffer carries no elements over.
+  vector.ResizeDefaultInit(size);
+  try {
+    if (size > 0) {
+      ReadAll(fd, vector.Data(), size * sizeof(T));
+    }
+  } catch (...) {
+    vector.Clear();
+    throw;
+  }
+}
+
+#endif
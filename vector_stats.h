@@ -0,0 +1,188 @@
+#ifndef VECTOR_STATS_H
+#define VECTOR_STATS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Buffer activity of the Vectors sharing one tag. A reallocation is any change of an existing
+// buffer's capacity, in place or not; bytes_moved counts the elements it had to carry over.
+// wasted_bytes sums capacity minus size over the buffers released so far.
+struct VectorStats {
+  uint64_t allocations = 0;
+  uint64_t reallocations = 0;
+  uint64_t releases = 0;
+  uint64_t bytes_allocated = 0;
+  uint64_t bytes_moved = 0;
+  uint64_t peak_capacity_bytes = 0;
+  uint64_t wasted_bytes = 0;
+};
+
+// Process-wide totals per tag, filled by Vectors using TaggedVectorStats in builds that
+// define VECTOR_STATS.
+class VectorStatsRegistry {
+public:
+  struct Counters {
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> reallocations{0};
+    std::atomic<uint64_t> releases{0};
+    std::atomic<uint64_t> bytes_allocated{0};
+    std::atomic<uint64_t> bytes_moved{0};
+    std::atomic<uint64_t> peak_capacity_bytes{0};
+    std::atomic<uint64_t> wasted_bytes{0};
+
+    void RecordCapacity(uint64_t bytes) {
+      uint64_t peak = peak_capacity_bytes.load(std::memory_order_relaxed);
+      while (bytes > peak && !peak_capacity_bytes.compare_exchange_weak(peak, bytes, std::memory_order_relaxed)) {
+      }
+    }
+
+    [[nodiscard]] VectorStats Load() const {
+      VectorStats stats;
+      stats.allocations = allocations.load(std::memory_order_relaxed);
+      stats.reallocations = reallocations.load(std::memory_order_relaxed);
+      stats.releases = releases.load(std::memory_order_relaxed);
+      stats.bytes_allocated = bytes_allocated.load(std::memory_order_relaxed);
+      stats.bytes_moved = bytes_moved.load(std::memory_order_relaxed);
+      stats.peak_capacity_bytes = peak_capacity_bytes.load(std::memory_order_relaxed);
+      stats.wasted_bytes = wasted_bytes.load(std::memory_order_relaxed);
+      return stats;
+    }
+  };
+
+private:
+  mutable std::mutex mutex_;
+  std::map<std::string, std::unique_ptr<Counters>, std::less<> > counters_;
+
+  static std::FILE *&ExitStream() {
+    static std::FILE *stream = nullptr;
+    return stream;
+  }
+
+public:
+  static VectorStatsRegistry &Global() {
+    static VectorStatsRegistry registry;
+    return registry;
+  }
+
+  // Counters of `tag`, created on first use. The reference stays valid for the lifetime of
+  // the registry.
+  Counters &For(const char *tag) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = counters_.find(tag);
+    if (it == counters_.end()) {
+      it = counters_.emplace(tag, std::make_unique<Counters>()).first;
+    }
+    return *it->second;
+  }
+
+  [[nodiscard]] std::vector<std::pair<std::string, VectorStats> > Snapshot() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::pair<std::string, VectorStats> > snapshot;
+    snapshot.reserve(counters_.size());
+    for (const auto &[tag, counters] : counters_) {
+      snapshot.emplace_back(tag, counters->Load());
+    }
+    return snapshot;
+  }
+
+  // Prints one line per tag, busiest reallocators first.
+  void Dump(std::FILE *out) const {
+    auto snapshot = Snapshot();
+    std::sort(snapshot.begin(), snapshot.end(), [](const auto &a, const auto &b) {
+      return a.second.bytes_moved > b.second.bytes_moved;
+    });
+    std::fprintf(out, "%-32s %12s %12s %16s %16s %16s\n", "tag", "allocations", "reallocs", "bytes moved",
+                 "peak capacity", "wasted bytes");
+    for (const auto &[tag, stats] : snapshot) {
+      std::fprintf(out, "%-32s %12llu %12llu %16llu %16llu %16llu\n", tag.c_str(),
+                   static_cast<unsigned long long>(stats.allocations),
+                   static_cast<unsigned long long>(stats.reallocations),
+                   static_cast<unsigned long long>(stats.bytes_moved),
+                   static_cast<unsigned long long>(stats.peak_capacity_bytes),
+                   static_cast<unsigned long long>(stats.wasted_bytes));
+    }
+  }
+
+  // Dumps the global registry to `out` when the program exits.
+  static void DumpAtExit(std::FILE *out = stderr) {
+    Global();
+    if (ExitStream() == nullptr) {
+      std::atexit([] { Global().Dump(ExitStream()); });
+    }
+    ExitStream() = out;
+  }
+};
+
+// String literal usable as a template argument: TaggedVectorStats<"parser.tokens">.
+template<std::size_t N>
+struct StatsTag {
+  char name[N] = {};
+
+  constexpr StatsTag(const char (&text)[N]) {  // NOLINT
+    std::copy_n(text, N, name);
+  }
+};
+
+// Instrumentation policies of Vector. The hooks receive sizes in bytes. NoVectorStats, the
+// default, has nothing to do.
+struct NoVectorStats {
+  void OnAllocate(std::size_t) {
+  }
+
+  void OnReallocate(std::size_t, std::size_t) {
+  }
+
+  void OnRelease(std::size_t, std::size_t) {
+  }
+};
+
+// Adds the activity of a Vector to the registry under Tag. Without VECTOR_STATS the hooks are
+// empty, so tagged vectors can stay in the code at no cost.
+template<StatsTag Tag>
+class TaggedVectorStats {
+#ifdef VECTOR_STATS
+  static VectorStatsRegistry::Counters &Counters() {
+    static VectorStatsRegistry::Counters &counters = VectorStatsRegistry::Global().For(Tag.name);
+    return counters;
+  }
+#endif
+
+public:
+  void OnAllocate([[maybe_unused]] std::size_t capacity_bytes) {
+#ifdef VECTOR_STATS
+    auto &counters = Counters();
+    counters.allocations.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes_allocated.fetch_add(capacity_bytes, std::memory_order_relaxed);
+    counters.RecordCapacity(capacity_bytes);
+#endif
+  }
+
+  void OnReallocate([[maybe_unused]] std::size_t new_capacity_bytes, [[maybe_unused]] std::size_t moved_bytes) {
+#ifdef VECTOR_STATS
+    auto &counters = Counters();
+    counters.reallocations.fetch_add(1, std::memory_order_relaxed);
+    counters.bytes_moved.fetch_add(moved_bytes, std::memory_order_relaxed);
+    counters.RecordCapacity(new_capacity_bytes);
+#endif
+  }
+
+  void OnRelease([[maybe_unused]] std::size_t size_bytes, [[maybe_unused]] std::size_t capacity_bytes) {
+#ifdef VECTOR_STATS
+    auto &counters = Counters();
+    counters.releases.fetch_add(1, std::memory_order_relaxed);
+    counters.wasted_bytes.fetch_add(capacity_bytes - size_bytes, std::memory_order_relaxed);
+#endif
+  }
+};
+
+#endif